@@ -0,0 +1,42 @@
+//
+//  PLPackageManager+Additions.swift
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+import Foundation
+
+public extension PackageManager {
+
+    // MARK: - Filtering
+
+    /**
+     Filter packages by role and tags using the interned tag index.
+
+     - parameter roles: The roles that results may have.
+     - parameter includedTags: Tags that every result must have.
+     - parameter excludedTags: Tags that no result may have.
+     - returns: The matching packages.
+     */
+    func packages(withRoles roles: Set<PackageRole> = Set(PackageRole.allCases), including includedTags: [String] = [], excluding excludedTags: [String] = []) -> [Package] {
+        let roleMask = roles.reduce(0) { $0 | (1 << $1.rawValue) }
+        return __packages(withRoleMask: UInt(roleMask), includingTags: includedTags, excludingTags: excludedTags)
+    }
+
+    // MARK: - Dependencies
+
+    /**
+     The packages that installing a package would pull in, without touching the queue.
+
+     - parameter package: The package to install.
+     - returns: The packages that would be installed or upgraded along with `package` and the total download size.
+     */
+    @MainActor
+    func dependencyClosure(of package: Package) -> (packages: [Package], downloadSize: UInt64) {
+        var downloadSize: UInt64 = 0
+        let packages = __dependencyClosure(of: package, downloadSize: &downloadSize)
+        return (packages, downloadSize)
+    }
+
+}
@@ -16,18 +16,46 @@ PL_APT_PKG_IMPORTS_BEGIN
 #include <apt-pkg/algorithms.h>
 #include <apt-pkg/sourcelist.h>
 PL_APT_PKG_IMPORTS_END
+
+#include <memory>
+#include <vector>
+
+class PLRecordCache;
+class PLTagIndex;
+class PLAuthorIndex;
+class PLDescriptionStore;
+class PLProvidesIndex;
+class PLReverseDependencyIndex;
 #endif
 
 @class PLSource;
 @class PLPackage;
+@class PLEmail;
+@class PLLiveQuery;
 
 NS_ASSUME_NONNULL_BEGIN
 
 /*!
  Notification constant that indicates when the database has been refreshed or initially imported.
+ 
+ The `userInfo` dictionary contains the `count` of updates. After a refresh it also contains the identifiers of the packages that were `added`, `removed` or `updated` since the previous import, where an update is a change to the candidate version, installed version or hold state. These keys are missing after the initial import.
  */
 extern NSNotificationName const PLDatabaseRefreshNotification NS_SWIFT_NAME(PLPackageManager.databaseDidRefreshNotification);
 
+/*!
+ Notification constant that indicates when packages have been added to or removed from `updates` without a full database refresh.
+
+ The `userInfo` dictionary contains the new `count` of updates as well as the `added` and `removed` packages.
+ */
+extern NSNotificationName const PLPackageUpdatesChangeNotification NS_SWIFT_NAME(PLPackageManager.updatesDidChangeNotification);
+
+/*!
+ Notification constant that indicates when the catalog wide indexes have been built after an import or updated after candidates changed.
+ 
+ The tag, author and maintainer indexes, the description store and the first seen snapshot are built in the background. Until this is posted, queries that rely on them read each package instead or, for the snapshot, return nothing.
+ */
+extern NSNotificationName const PLPackageIndexesUpdateNotification NS_SWIFT_NAME(PLPackageManager.indexesDidUpdateNotification);
+
 extern NSString* const PLErrorDomain;
 
 extern NSInteger const PLPackageManagerErrorGeneral;
@@ -64,8 +92,90 @@ NS_SWIFT_NAME(PackageManager)
  The internal package problem resolver object used by libapt.
  */
 - (nullable pkgProblemResolver *)resolver;
+
+/*!
+ The control stanza cache for the current cache generation, or `NULL` if the cache has not been imported.
+ 
+ It keeps up to `Plains::RecordCacheLimit` megabytes of stanzas, 64 by default, before dropping the ones read longest ago.
+ */
+- (std::shared_ptr<PLRecordCache>)recordCache;
+
+/*!
+ The tag index of the current cache generation if it has finished building and `package` belongs to this generation, otherwise `NULL`.
+ */
+- (std::shared_ptr<PLTagIndex>)tagIndexForPackage:(PLPackage *)package;
+
+/*!
+ The author and maintainer indexes of the current cache generation if they have finished building and `package` belongs to this generation, otherwise `NULL`.
+ */
+- (std::shared_ptr<PLAuthorIndex>)authorIndexForPackage:(PLPackage *)package;
+- (std::shared_ptr<PLAuthorIndex>)maintainerIndexForPackage:(PLPackage *)package;
+
+/*!
+ The in-memory description store of the current cache generation if `Plains::DescriptionStore` is enabled, it has finished building and `package` belongs to this generation, otherwise `NULL`.
+ */
+- (std::shared_ptr<PLDescriptionStore>)descriptionStoreForPackage:(PLPackage *)package;
+
+/*!
+ The policy candidate version of a package.
+ 
+ Candidates are computed once per policy generation and shared by every lookup, so this does not re-evaluate pins.
+ 
+ - parameter iterator: The package to retrieve the candidate of.
+ - returns: The candidate version, or an end iterator if the package has no candidate.
+ */
+- (pkgCache::VerIterator)candidateForPackageIterator:(pkgCache::PkgIterator const &)iterator;
+
+/*!
+ The imported package object for a package in the current cache generation.
+ 
+ - parameter iterator: The package to look up.
+ - returns: The shared `PLPackage` for the package's candidate, or `NULL` if it has no candidate or belongs to a different generation.
+ */
+- (nullable PLPackage *)packageForIterator:(pkgCache::PkgIterator const &)iterator;
+
+/*!
+ The index of what installed packages depend on and conflict with in the current cache generation, built on first use, or `NULL` if the cache has not been imported.
+ */
+- (std::shared_ptr<PLReverseDependencyIndex>)reverseDependencyIndex;
+
+/*!
+ The provides index of the current cache generation, built on first use, or `NULL` if the cache has not been imported.
+ */
+- (std::shared_ptr<PLProvidesIndex>)providesIndex;
+
+/*!
+ The policy candidate of every package in the current cache generation, indexed by package ID.
+ 
+ Entries are `NULL` for packages without a candidate.
+ */
+- (std::vector<pkgCache::Version *>)candidateVersions;
+
+/*!
+ A concurrent queue for work that reads the package cache off the main thread.
+ 
+ The cache is not closed or replaced until every block submitted to this queue has finished, so blocks can safely hold on to iterators into the cache that was current when they were submitted.
+ */
+- (dispatch_queue_t)cacheReaderQueue;
 #endif
 
+/*!
+ A counter that is incremented whenever package candidates are recomputed, either by an import or by a pin change.
+ */
+@property (nonatomic, readonly) NSUInteger policyGeneration;
+
+/*!
+ A counter that is incremented whenever a new cache is imported. State that holds package IDs or iterators is only valid for the generation it was taken in, even if the new cache happens to be mapped at the same address.
+ */
+@property (nonatomic, readonly) NSUInteger cacheGeneration;
+
+/*!
+ Memory used by the compressed description store in bytes, or `0` if it is disabled or still being built.
+ 
+ The store is enabled by setting `Plains::DescriptionStore` to true before importing. Descriptions and description searches are then served from memory instead of the Packages files.
+ */
+@property (nonatomic, readonly) NSUInteger descriptionStoreSize;
+
 /*!
  Reads packages from libapt's cache and imports them into PLPackage objects that can be accessed through the `packages` property.
  
@@ -85,6 +195,8 @@ NS_SWIFT_NAME(PackageManager)
 /*!
  Packages that have an available update or are pinned by a repository and the installed version is not the version pinned.
  
+ This array is derived from an update set that is maintained incrementally as hold states and candidates change, observe `PLPackageUpdatesChangeNotification` to be told when it changes.
+ 
  - returns: An array of PLPackage objects
  */
 @property (nonatomic, strong, readonly) NSArray <PLPackage *> *updates;
@@ -103,6 +215,18 @@ NS_SWIFT_NAME(PackageManager)
  */
 @property (readonly) NSDictionary <NSString *, NSNumber *> *sections;
 
+/*!
+ Filter packages by role and tags using the interned tag index.
+
+ Tags of every package are interned in the background after each import, so this is a handful of bitwise operations over the catalog rather than a scan of every package's `Tag` field. If the index is still being built every package's tags are read instead, this never waits for the index.
+
+ - parameter roleMask: A mask of the roles to include, where each `PLPackageRole` is represented by `1 << role`.
+ - parameter includedTags: Tags that every result must have.
+ - parameter excludedTags: Tags that no result may have.
+ - returns: The matching packages.
+ */
+- (NSArray <PLPackage *> *)packagesWithRoleMask:(NSUInteger)roleMask includingTags:(nullable NSArray <NSString *> *)includedTags excludingTags:(nullable NSArray <NSString *> *)excludedTags NS_REFINED_FOR_SWIFT;
+
 /*!
  Filter the `packages` array for packages that match a certain filter.
 
@@ -120,6 +244,27 @@ NS_SWIFT_NAME(PackageManager)
  */
 - (void)fetchPackagesMatchingFilter:(BOOL (^)(PLPackage *package))filter completion:(void (^)(NSArray <PLPackage *> *packages))completion;
 
+/*!
+ Retrieve several control fields for several packages at once.
+
+ Each package's stanza is parsed at most once and uncached stanzas are read in file order, which is considerably faster than calling `getField:` for every field of every package when filling a list.
+
+ - parameter fields: The control fields to retrieve.
+ - parameter packages: The packages to retrieve the fields of.
+ - returns: A dictionary keyed by field name where each value is an array in the same order as `packages`, containing the value of that field or `NSNull` if the package does not have it.
+ */
+- (NSDictionary <NSString *, NSArray *> *)valuesForFields:(NSArray <NSString *> *)fields ofPackages:(NSArray <PLPackage *> *)packages NS_SWIFT_NAME(values(forFields:of:));
+
+/*!
+ Warm the field cache for a range of packages in the background.
+
+ Intended to be called as a list scrolls with the range of rows that are visible or about to become visible. Records are read on a background queue in file order so that `getField:` and friends are cache hits once the rows are displayed. Calling this again cancels any prefetch that has not finished yet.
+
+ - parameter packages: The packages backing the list.
+ - parameter range: The indexes in `packages` to prefetch, clamped to the bounds of `packages`.
+ */
+- (void)prefetchRecordsForPackages:(NSArray <PLPackage *> *)packages inRange:(NSRange)range NS_SWIFT_NAME(prefetchRecords(for:in:));
+
 /*!
  Starts the process of downloading and installing packages that have been queued.
  
@@ -154,11 +299,122 @@ NS_SWIFT_NAME(PackageManager)
 /*!
  Perform a full search for any packages whose author name  contains `authorName`.
  
+ Only the distinct author names of the catalog are compared, using the author index that is built after each import. Until the index is ready every package's author is compared instead.
+ 
  - parameter authorName: The author name to search for.
  - parameter completion: Completion block to be run when results are retrieved.
  */
 - (void)searchForPackagesWithAuthorName:(NSString *)authorName completion:(void (^)(NSArray <PLPackage *> *packages))completion;
 
+/*!
+ All packages by an author, such as for a "More by this developer" list.
+ 
+ Authors with an email address are matched by email, otherwise by their case and diacritic folded name. Until the author index is ready every package's author is compared instead.
+ 
+ - parameter author: The author to look up, usually the `author` of another package.
+ - returns: The packages whose `Author` field names `author`, in package ID order.
+ */
+- (NSArray <PLPackage *> *)packagesByAuthor:(PLEmail *)author NS_SWIFT_NAME(packages(byAuthor:));
+
+/*!
+ Start maintaining a live query.
+ 
+ The query is evaluated immediately if packages have already been imported. After each import only the packages in the generation's change set are re-checked, and hold or pin changes re-check only the packages they affect. Queries are held weakly and stop being maintained when they are deallocated.
+ 
+ - parameter query: The query to register.
+ */
+- (void)registerLiveQuery:(PLLiveQuery *)query NS_SWIFT_NAME(register(_:));
+
+/*!
+ Stop maintaining a live query.
+ 
+ - parameter query: The query to unregister.
+ */
+- (void)unregisterLiveQuery:(PLLiveQuery *)query NS_SWIFT_NAME(unregister(_:));
+
+/*!
+ Packages that were first seen by an import after `date`, most recent first.
+ 
+ Each import diffs the candidate stanzas against the previous one and records when every package and version was first seen under `Dir::State`. Packages that were already there the first time a snapshot was taken are never considered new. The result is empty until the snapshot has been diffed, observe `PLPackageIndexesUpdateNotification` to be told when it is ready.
+ 
+ - parameter date: The date to compare against.
+ - returns: The newly added packages.
+ */
+- (NSArray <PLPackage *> *)packagesAddedSince:(NSDate *)date NS_SWIFT_NAME(packagesAdded(since:));
+
+/*!
+ Packages whose current version was first seen by an import after `date`, most recent first. Newly added packages are not included.
+ 
+ - parameter date: The date to compare against.
+ - returns: The updated packages.
+ */
+- (NSArray <PLPackage *> *)packagesUpdatedSince:(NSDate *)date NS_SWIFT_NAME(packagesUpdated(since:));
+
+/*!
+ The date `package` was first seen by an import.
+ 
+ - parameter package: The package to look up.
+ - returns: The date, or `NULL` if it is unknown or the snapshot is still being built.
+ */
+- (nullable NSDate *)firstSeenDateForPackage:(PLPackage *)package NS_SWIFT_NAME(firstSeenDate(for:));
+
+/*!
+ All packages maintained by `maintainer`.
+ 
+ - parameter maintainer: The maintainer to look up, usually the `maintainer` of another package.
+ - returns: The packages whose `Maintainer` field names `maintainer`, in package ID order.
+ */
+- (NSArray <PLPackage *> *)packagesByMaintainer:(PLEmail *)maintainer NS_SWIFT_NAME(packages(byMaintainer:));
+
+/*!
+ The packages that installing a package would pull in, worked out from the candidate table without touching the queue.
+ 
+ `Depends` and `Pre-Depends` are followed transitively. An or-group that is already satisfied by an installed package pulls in nothing, otherwise the first alternative whose candidate satisfies it is used, including through provides. The result can differ from the resolver when it picks a different alternative or needs to remove conflicting packages.
+ 
+ Closures are shared between packages and kept until candidates change, so this is cheap enough to call whenever a package is shown. Unlike the indexes this has to be called on the main thread, the memo is filled in as closures are asked for and is dropped on the main thread by imports and pin changes.
+ 
+ - parameter package: The package to install, at the version it represents.
+ - parameter downloadSize: Set to the total download size of `package` and everything it pulls in. Can be `NULL`.
+ - returns: The packages that would be installed or upgraded along with `package`, in package ID order and not including `package` itself.
+ */
+- (NSArray <PLPackage *> *)dependencyClosureOfPackage:(PLPackage *)package downloadSize:(nullable unsigned long long *)downloadSize NS_SWIFT_UI_ACTOR NS_REFINED_FOR_SWIFT;
+
+/*!
+ The installed packages that depend on a package, directly or through something it provides.
+ 
+ Only installed versions are considered and only `Depends` and `Pre-Depends`. The index behind this is built on first use and kept until the next import.
+ 
+ - parameter package: The package to find the dependents of.
+ - returns: The installed dependents in package ID order.
+ */
+- (NSArray <PLPackage *> *)installedDependentsOfPackage:(PLPackage *)package NS_SWIFT_NAME(installedDependents(of:));
+
+/*!
+ The installed packages that would break if packages were removed, without queueing anything.
+ 
+ A dependent breaks once every installed package that satisfied one of its dependencies is being removed, and everything that depends on it is then checked in turn. This answers what the resolver would have to remove along with `packages`, assuming nothing new is installed to replace them.
+ 
+ - parameter packages: The packages to remove.
+ - returns: The installed packages that would be left with an unsatisfied dependency, in package ID order and not including `packages`.
+ */
+- (NSArray <PLPackage *> *)removalImpactOfPackages:(NSArray <PLPackage *> *)packages NS_SWIFT_NAME(removalImpact(of:));
+
+/*!
+ Every version that provides a package name, for example to let the user choose what should satisfy a virtual package.
+ 
+ - parameter name: The provided package name.
+ - returns: The providing versions with installed ones first. The shared package object is used when a provider is its package's candidate.
+ */
+- (NSArray <PLPackage *> *)providersOfVirtualPackage:(NSString *)name NS_SWIFT_NAME(providers(ofVirtualPackage:));
+
+/*!
+ The installed version that provides a package name.
+ 
+ - parameter name: The provided package name.
+ - returns: The installed provider, or `nil` if nothing installed provides `name`.
+ */
+- (nullable PLPackage *)installedProviderOfVirtualPackage:(NSString *)name NS_SWIFT_NAME(installedProvider(ofVirtualPackage:));
+
 /*!
  Get the candidate version of a package. This is set to the package's latest available version by default but can be overridden (in the case of a package being downgraded)
  
@@ -201,6 +457,55 @@ NS_SWIFT_NAME(PackageManager)
  - parameter held: `true` if the package is to be held, false otherwise.
  */
 - (void)setPackage:(PLPackage *)package held:(BOOL)held;
+
+/*!
+ Modify the held state of several packages at once.
+ 
+ All of the selections are written with a single `dpkg --set-selections` run and `PLPackageUpdatesChangeNotification` is posted exactly once for the batch, even if no package gained or lost an update. Packages that are already in the requested state are skipped.
+ 
+ - parameter packages: The packages to modify the held state of.
+ - parameter held: `true` if the packages are to be held, false otherwise.
+ - returns: `false` if the selections could not be written, in which case no package changes state and the reason can be read from `PLErrorManager`.
+ */
+- (BOOL)setPackages:(NSArray <PLPackage *> *)packages held:(BOOL)held;
+
+/*!
+ Change the pin priority of every package file offered by a source.
+ 
+ Only the candidates of packages that the source offers are recomputed, the cache is not reopened.
+ 
+ - parameter pin: The new pin priority.
+ - parameter source: The source to change the pin priority of.
+ */
+- (void)setPin:(short)pin forSource:(PLSource *)source;
+
+/*!
+ Pin a specific version of a package.
+ 
+ Only the candidate of `package` is recomputed, the cache is not reopened.
+ 
+ - parameter pin: The new pin priority.
+ - parameter package: The package version to pin.
+ */
+- (void)setPin:(short)pin forPackage:(PLPackage *)package;
+
+/*!
+ Whether or not a package is currently held back from updates.
+
+ This reflects hold changes made through `setPackage:held:` immediately, without waiting for the cache to be reopened.
+
+ - parameter package: The package to check the held state of.
+ - returns: `true` if the package is held, `false` otherwise.
+ */
+- (BOOL)isPackageHeld:(PLPackage *)package;
+
+/*!
+ Whether or not a package is an update, another version of an installed package that isn't held back. `-[PLPackage hasUpdate]` is answered by this.
+ 
+ - parameter package: The package to check.
+ - returns: `true` if `package` is not the installed version and the package is not held, `false` otherwise.
+ */
+- (BOOL)packageHasUpdate:(PLPackage *)package;
 @end
 
 NS_ASSUME_NONNULL_END
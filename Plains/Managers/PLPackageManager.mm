@@ -9,14 +9,27 @@
 
 #import "PLSource.h"
 #import "PLPackage.h"
+#import "PLLiveQuery.h"
 #import "PLConsoleDelegate.h"
 #import "PLSourceManager.h"
 #import "PLConfig.h"
+#import "NSString+Plains.h"
+#import "PLBitset.h"
+#import "PLRecordCache.h"
+#import "PLTagIndex.h"
+#import "PLAuthorIndex.h"
+#import "PLDescriptionStore.h"
+#import "PLSnapshot.h"
+#import "PLGenerationSummary.h"
+#import "PLDependencyClosure.h"
+#import "PLReverseDependencyIndex.h"
+#import "PLProvidesIndex.h"
 #import <Plains/Plains-Swift.h>
 
 PL_APT_PKG_IMPORTS_BEGIN
 #import <apt-pkg/pkgsystem.h>
 #import <apt-pkg/pkgcache.h>
+#import <apt-pkg/policy.h>
 #import <apt-pkg/update.h>
 #import <apt-pkg/acquire.h>
 #import <apt-pkg/acquire-item.h>
@@ -31,12 +44,17 @@ PL_APT_PKG_IMPORTS_BEGIN
 PL_APT_PKG_IMPORTS_END
 
 #include <fcntl.h>
+#include <sys/statvfs.h>
 #include <unistd.h>
 #include <spawn.h>
+#include <atomic>
+#include <map>
 
 extern char **environ;
 
 NSNotificationName const PLDatabaseRefreshNotification = @"PLDatabaseRefreshNotification";
+NSNotificationName const PLPackageUpdatesChangeNotification = @"PLPackageUpdatesChangeNotification";
+NSNotificationName const PLPackageIndexesUpdateNotification = @"PLPackageIndexesUpdateNotification";
 
 NSString *const PLErrorDomain = @"PLErrorDomain";
 NSInteger const PLPackageManagerErrorGeneral = 0;
@@ -148,12 +166,38 @@ public:
 @interface PLPackageManager () {
     pkgCacheFile *cache;
     pkgRecords *records;
+    std::shared_ptr<PLRecordCache> recordCache;
+    dispatch_queue_t prefetchQueue;
+    std::atomic<NSUInteger> prefetchRequest;
+    dispatch_queue_t indexQueue;
+    dispatch_queue_t readerQueue;
+    std::atomic<NSUInteger> indexGeneration;
+    std::shared_ptr<PLTagIndex> tagIndex;
+    std::shared_ptr<PLAuthorIndex> authorIndex;
+    std::shared_ptr<PLAuthorIndex> maintainerIndex;
+    std::shared_ptr<PLDescriptionStore> descriptionStore;
+    std::shared_ptr<PLSnapshot> snapshot;
+    std::shared_ptr<PLDependencyClosure> dependencyClosure;
+    std::shared_ptr<PLReverseDependencyIndex> reverseDependencyIndex;
+    std::shared_ptr<PLProvidesIndex> providesIndex;
     pkgProblemResolver *resolver;
     PLDownloadStatus *status;
     PLInstallStatus *installStatus;
 //    APT::Progress::PackageManager *installStatus;
     NSArray *packages;
     NSArray *updates;
+    std::vector<PLPackage *> packagesByID;
+    std::vector<pkgCache::Version *> indexedVersions;
+    std::vector<pkgCache::Version *> candidateVersions;
+    pkgCache *candidateCache;
+    std::map<map_id_t, std::vector<map_id_t>> releasePackageIDs;
+    NSUInteger policyGeneration;
+    NSUInteger cacheGeneration;
+    PLBitset updatesSet;
+    PLBitset heldSet;
+    PLGenerationSummary generationSummary;
+    NSDictionary *refreshChanges;
+    NSHashTable <PLLiveQuery *> *liveQueries;
     BOOL cacheOpened;
     BOOL refreshing;
 //    int finishFD;
@@ -177,6 +221,10 @@ public:
     
     if (self) {
         self->cache = new pkgCacheFile();
+        self->prefetchQueue = dispatch_queue_create("com.getzbra.plains.prefetch", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+        self->indexQueue = dispatch_queue_create("com.getzbra.plains.index", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+        self->readerQueue = dispatch_queue_create("com.getzbra.plains.reader", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_CONCURRENT, QOS_CLASS_USER_INITIATED, 0));
+        self->liveQueries = [NSHashTable weakObjectsHashTable];
     }
     
     return self;
@@ -197,6 +245,25 @@ public:
     return self->resolver;
 }
 
+- (std::shared_ptr<PLRecordCache>)recordCache {
+    return self->recordCache;
+}
+
+- (dispatch_queue_t)cacheReaderQueue {
+    return self->readerQueue;
+}
+
+- (void)waitForCacheReaders {
+    // Index builds and prefetches check their token before every record, so one that is in progress stops at the next record
+    self->indexGeneration++;
+    self->prefetchRequest++;
+    dispatch_sync(self->indexQueue, ^{});
+    dispatch_sync(self->prefetchQueue, ^{});
+    
+    // The barrier only runs once every reader that was submitted before it has returned
+    dispatch_barrier_sync(self->readerQueue, ^{});
+}
+
 - (BOOL)openCache {
     if (cacheOpened) return true;
     
@@ -220,6 +287,7 @@ public:
 
 - (void)closeCache {
     if (cacheOpened) {
+        [self waitForCacheReaders];
         cache->Close();
         cacheOpened = false;
     }
@@ -231,16 +299,15 @@ public:
         if (temporaryCache->Open(NULL, false)) {
             pkgDepCache *depCache = temporaryCache->GetDepCache();
             self->records = new pkgRecords(*depCache);
-            NSArray *import = [self packagesAndUpdatesFromDepCache:depCache];
-
-            self->packages = import[0];
-            self->updates = import[1];
+            [self importPackagesFromDepCache:depCache];
 
+            [self waitForCacheReaders];
             cache->Close();
             self->cache = temporaryCache;
             resolver = new pkgProblemResolver(*self->cache);
+            [self rebuildIndexes];
 
-            [[NSNotificationCenter defaultCenter] postNotificationName:PLDatabaseRefreshNotification object:nil userInfo:@{@"count": @(self->updates.count)}];
+            [self postDatabaseRefreshNotification];
             return;
         }
     }
@@ -250,23 +317,792 @@ public:
     
     pkgDepCache *depCache = cache->GetDepCache();
     self->records = new pkgRecords(*depCache);
-    NSArray *import = [self packagesAndUpdatesFromDepCache:depCache];
+    [self importPackagesFromDepCache:depCache];
+    [self rebuildIndexes];
     
-    self->packages = import[0];
-    self->updates = import[1];
-    
-    [[NSNotificationCenter defaultCenter] postNotificationName:PLDatabaseRefreshNotification object:nil userInfo:@{@"count": @(self->updates.count)}];
+    [self postDatabaseRefreshNotification];
 }
 
-- (NSArray <NSArray *> *)packagesAndUpdatesFromDepCache:(pkgDepCache *)depCache {
-    NSMutableArray *packages = [NSMutableArray arrayWithCapacity:depCache->Head().PackageCount];
-    NSMutableArray *updates = [NSMutableArray arrayWithCapacity:16];
+- (void)importPackagesFromDepCache:(pkgDepCache *)depCache {
+    size_t packageCount = depCache->Head().PackageCount;
+    NSMutableArray *packages = [NSMutableArray arrayWithCapacity:packageCount];
+    
+    // Enough for every stanza of a few large repositories, beyond that the ones read longest ago are read again when needed
+    size_t recordCacheLimit = (size_t)_config->FindI("Plains::RecordCacheLimit", 64) << 20;
+    self->recordCache = std::make_shared<PLRecordCache>(depCache->GetCache(), *self->records, recordCacheLimit);
+    
+    self->packagesByID.assign(packageCount, nil);
+    self->candidateVersions.assign(packageCount, NULL);
+    self->candidateCache = &depCache->GetCache();
+    self->releasePackageIDs.clear();
+    self->reverseDependencyIndex.reset();
+    self->providesIndex.reset();
+    self->policyGeneration++;
+    self->cacheGeneration++;
+    self->heldSet = PLBitset(packageCount);
+    self->updatesSet = PLBitset(packageCount);
+    PLGenerationSummary summary;
+    summary.reserve(packageCount);
     for (pkgCache::PkgIterator iterator = depCache->PkgBegin(); !iterator.end(); iterator++) {
-        PLPackage *package = [[PLPackage alloc] initWithIterator:depCache->GetPolicy().GetCandidateVer(iterator) depCache:depCache records:self->records];
+        if (iterator->SelectedState == pkgCache::State::Hold) {
+            self->heldSet.set(iterator->ID);
+        }
+        
+        pkgCache::VerIterator candidate = depCache->GetPolicy().GetCandidateVer(iterator);
+        if (!candidate.end()) {
+            self->candidateVersions[iterator->ID] = candidate;
+        }
+        
+        PLPackage *package = [[PLPackage alloc] initWithIterator:candidate depCache:depCache records:self->records];
+        if (!package) continue;
+        
+        [packages addObject:package];
+        self->packagesByID[iterator->ID] = package;
+        if ([self packageHasUpdate:package]) {
+            self->updatesSet.set(iterator->ID);
+        }
+        
+        // Live queries can depend on installed and held state as well, so a change to either counts as an update
+        std::string state = candidate.VerStr();
+        state += '\n';
+        if (!iterator.CurrentVer().end()) state += iterator.CurrentVer().VerStr();
+        if (self->heldSet.test(iterator->ID)) state += "\nhold";
+        summary.addPackage(iterator.FullName(true), std::move(state));
+    }
+    
+    self->packages = packages;
+    self->updates = nil;
+    
+    summary.finish();
+    if (self->generationSummary.empty()) {
+        self->refreshChanges = nil;
+    } else {
+        PLChangeSet changes = summary.diff(self->generationSummary);
+        self->refreshChanges = @{
+            @"added": [self identifiersFromNames:changes.added],
+            @"removed": [self identifiersFromNames:changes.removed],
+            @"updated": [self identifiersFromNames:changes.updated],
+        };
+    }
+    self->generationSummary = std::move(summary);
+}
+
+- (NSArray <NSString *> *)identifiersFromNames:(std::vector<std::string> const &)names {
+    NSMutableArray *identifiers = [NSMutableArray arrayWithCapacity:names.size()];
+    for (std::string const &name : names) {
+        [identifiers addObject:[NSString plains_stringWithStdString:name]];
+    }
+    return identifiers;
+}
+
+- (void)postDatabaseRefreshNotification {
+    [self updateLiveQueries];
+    [[NSNotificationCenter defaultCenter] postNotificationName:PLDatabaseRefreshNotification object:nil userInfo:[self refreshUserInfo]];
+}
+
+- (NSDictionary *)refreshUserInfo {
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithObject:@(self->updatesSet.count()) forKey:@"count"];
+    if (self->refreshChanges) {
+        [userInfo addEntriesFromDictionary:self->refreshChanges];
+    }
+    return userInfo;
+}
+
+#pragma mark - Live Queries
+
+- (void)registerLiveQuery:(PLLiveQuery *)query {
+    [self->liveQueries addObject:query];
+    if (self->packages) {
+        [query reloadWithPackages:self->packages];
+    }
+}
+
+- (void)unregisterLiveQuery:(PLLiveQuery *)query {
+    [self->liveQueries removeObject:query];
+}
+
+- (void)updateLiveQueries {
+    NSArray <PLLiveQuery *> *queries = self->liveQueries.allObjects;
+    if (queries.count == 0) return;
+    
+    if (!self->refreshChanges) {
+        for (PLLiveQuery *query in queries) {
+            [query reloadWithPackages:self->packages];
+        }
+        return;
+    }
+    
+    NSMutableArray *changed = [NSMutableArray new];
+    for (NSString *identifier in [self->refreshChanges[@"added"] arrayByAddingObjectsFromArray:self->refreshChanges[@"updated"]]) {
+        PLPackage *package = [self packageWithIdentifier:identifier];
+        if (package) [changed addObject:package];
+    }
+    NSArray *removed = self->refreshChanges[@"removed"];
+    for (PLLiveQuery *query in queries) {
+        [query updateWithChangedPackages:changed removedIdentifiers:removed packageProvider:^PLPackage *(NSString *identifier) {
+            return [self packageWithIdentifier:identifier];
+        }];
+    }
+}
+
+- (void)updateLiveQueriesWithChangedPackages:(NSArray <PLPackage *> *)packages {
+    for (PLLiveQuery *query in self->liveQueries.allObjects) {
+        [query updateWithChangedPackages:packages removedIdentifiers:@[] packageProvider:nil];
+    }
+}
+
+#pragma mark - Indexes
+
+/*!
+ Build the catalog wide indexes of a newly imported generation in the background.
+ 
+ This is only called for an import, which is also the only time the snapshot is diffed and saved. A candidate that changed because of a pin was already in the catalog and goes through `updateIndexesForPackageIDs:` instead. It has to be called once the previous cache has been closed, closing it cancels and waits for any build that is still running on `indexQueue`.
+ */
+- (void)rebuildIndexes {
+    NSUInteger generation = ++self->indexGeneration;
+    std::atomic_store(&self->tagIndex, std::shared_ptr<PLTagIndex>());
+    std::atomic_store(&self->authorIndex, std::shared_ptr<PLAuthorIndex>());
+    std::atomic_store(&self->maintainerIndex, std::shared_ptr<PLAuthorIndex>());
+    std::atomic_store(&self->descriptionStore, std::shared_ptr<PLDescriptionStore>());
+    std::atomic_store(&self->snapshot, std::shared_ptr<PLSnapshot>());
+    self->dependencyClosure.reset();
+    
+    std::shared_ptr<PLRecordCache> recordCache = self->recordCache;
+    if (!recordCache) return;
+    
+    size_t packageCount = self->packagesByID.size();
+    std::vector<pkgCache::VerIterator> versions;
+    versions.reserve(packageCount);
+    self->indexedVersions.assign(packageCount, NULL);
+    for (PLPackage *package : self->packagesByID) {
+        if (!package) continue;
+        
+        versions.push_back(package.verIterator);
+        self->indexedVersions[package.package->ID] = package.verIterator;
+    }
+    
+    bool buildDescriptionStore = _config->FindB("Plains::DescriptionStore", false);
+    std::string snapshotPath = _config->FindDir("Dir::State") + "plains-snapshot";
+    pkgVersioningSystem *versioningSystem = _system->VS;
+    
+    // Catalog wide indexes need every record, build them in file order in the background so that import stays fast
+    dispatch_async(self->indexQueue, ^{
+        if (self->indexGeneration != generation) return;
+        
+        std::shared_ptr<PLTagIndex> tagIndex = std::make_shared<PLTagIndex>(packageCount);
+        std::shared_ptr<PLAuthorIndex> authorIndex = std::make_shared<PLAuthorIndex>(packageCount);
+        std::shared_ptr<PLAuthorIndex> maintainerIndex = std::make_shared<PLAuthorIndex>(packageCount);
+        std::shared_ptr<PLDescriptionStore> descriptionStore;
+        if (buildDescriptionStore) {
+            descriptionStore = std::make_shared<PLDescriptionStore>(packageCount);
+        }
+        std::shared_ptr<PLSnapshot> snapshot = std::make_shared<PLSnapshot>(packageCount);
+        snapshot->load(snapshotPath);
+        int64_t now = (int64_t)time(NULL);
+        auto isNewer = [versioningSystem](std::string const &newVersion, std::string const &oldVersion) {
+            return versioningSystem->CmpVersion(newVersion, oldVersion) > 0;
+        };
+        
+        recordCache->visit(versions, [&](size_t index, pkgRecords::Parser &parser) {
+            // The cache the versions belong to is about to be closed, nothing may be read from it anymore
+            if (self->indexGeneration != generation) return false;
+            
+            uint32_t packageID = versions[index].ParentPkg()->ID;
+            const char *start;
+            const char *stop;
+            parser.GetRec(start, stop);
+            snapshot->addPackage(packageID, versions[index].ParentPkg().FullName(), versions[index].VerStr(), start, stop, now, isNewer);
+            
+            std::string tags = parser.RecordField("Tag");
+            if (!tags.empty()) {
+                tagIndex->addPackage(packageID, tags.data(), tags.size());
+            }
+            authorIndex->addPackage(packageID, parser.RecordField("Author"));
+            maintainerIndex->addPackage(packageID, parser.RecordField("Maintainer"));
+            if (descriptionStore) {
+                descriptionStore->addPackage(packageID, parser.ShortDesc(), PLDescriptionStore::formatLongDescription(parser.LongDesc()));
+            }
+            return true;
+        });
+        if (self->indexGeneration != generation) return;
+        
+        if (descriptionStore) {
+            descriptionStore->finish();
+        }
+        
+        if (self->indexGeneration == generation) {
+            std::atomic_store(&self->tagIndex, tagIndex);
+            std::atomic_store(&self->authorIndex, authorIndex);
+            std::atomic_store(&self->maintainerIndex, maintainerIndex);
+            std::atomic_store(&self->descriptionStore, descriptionStore);
+            std::atomic_store(&self->snapshot, snapshot);
+            snapshot->save(snapshotPath);
+            
+            dispatch_async(dispatch_get_main_queue(), ^{
+                if (self->indexGeneration != generation) return;
+                [[NSNotificationCenter defaultCenter] postNotificationName:PLPackageIndexesUpdateNotification object:nil];
+            });
+        }
+    });
+}
+
+/*!
+ Replace the index entries of packages whose candidate changed without a new import.
+ 
+ Only the changed records are read, on `indexQueue` after any build that is still running, and the tag and author indexes are copied before they are changed so that readers never see them half updated. The snapshot is left alone.
+ 
+ - parameter packageIDs: The packages whose candidate changed.
+ */
+- (void)updateIndexesForPackageIDs:(std::vector<map_id_t> const &)packageIDs {
+    std::shared_ptr<PLRecordCache> recordCache = self->recordCache;
+    if (!recordCache || packageIDs.empty()) return;
+    
+    // Packages that lost their candidate are only removed
+    std::vector<pkgCache::VerIterator> versions;
+    for (map_id_t packageID : packageIDs) {
+        PLPackage *package = self->packagesByID[packageID];
+        if (package) versions.push_back(package.verIterator);
+    }
+    
+    // Blocks don't copy through a reference
+    std::vector<map_id_t> changedIDs = packageIDs;
+    NSUInteger generation = self->indexGeneration;
+    dispatch_async(self->indexQueue, ^{
+        if (self->indexGeneration != generation) return;
+        
+        std::shared_ptr<PLTagIndex> currentTagIndex = std::atomic_load(&self->tagIndex);
+        std::shared_ptr<PLAuthorIndex> currentAuthorIndex = std::atomic_load(&self->authorIndex);
+        std::shared_ptr<PLAuthorIndex> currentMaintainerIndex = std::atomic_load(&self->maintainerIndex);
+        std::shared_ptr<PLDescriptionStore> descriptionStore = std::atomic_load(&self->descriptionStore);
+        if (!currentTagIndex || !currentAuthorIndex || !currentMaintainerIndex) return;
+        
+        auto tagIndex = std::make_shared<PLTagIndex>(*currentTagIndex);
+        auto authorIndex = std::make_shared<PLAuthorIndex>(*currentAuthorIndex);
+        auto maintainerIndex = std::make_shared<PLAuthorIndex>(*currentMaintainerIndex);
+        for (map_id_t packageID : changedIDs) {
+            tagIndex->removePackage(packageID);
+            authorIndex->removePackage(packageID);
+            maintainerIndex->removePackage(packageID);
+        }
+        
+        recordCache->visit(versions, [&](size_t index, pkgRecords::Parser &parser) {
+            if (self->indexGeneration != generation) return false;
+            
+            uint32_t packageID = versions[index].ParentPkg()->ID;
+            std::string tags = parser.RecordField("Tag");
+            if (!tags.empty()) {
+                tagIndex->addPackage(packageID, tags.data(), tags.size());
+            }
+            authorIndex->addPackage(packageID, parser.RecordField("Author"));
+            maintainerIndex->addPackage(packageID, parser.RecordField("Maintainer"));
+            if (descriptionStore) {
+                descriptionStore->replacePackage(packageID, parser.ShortDesc(), PLDescriptionStore::formatLongDescription(parser.LongDesc()));
+            }
+            return true;
+        });
+        if (self->indexGeneration != generation) return;
+        
+        std::atomic_store(&self->tagIndex, tagIndex);
+        std::atomic_store(&self->authorIndex, authorIndex);
+        std::atomic_store(&self->maintainerIndex, maintainerIndex);
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (self->indexGeneration != generation) return;
+            
+            for (map_id_t packageID : changedIDs) {
+                PLPackage *package = self->packagesByID[packageID];
+                self->indexedVersions[packageID] = package ? (pkgCache::Version *)package.verIterator : NULL;
+            }
+            [[NSNotificationCenter defaultCenter] postNotificationName:PLPackageIndexesUpdateNotification object:nil];
+        });
+    });
+}
+
+- (std::shared_ptr<PLTagIndex>)tagIndex {
+    // Never waits for a build in progress, PLPackageIndexesUpdateNotification is posted once it is done
+    return std::atomic_load(&self->tagIndex);
+}
+
+- (BOOL)isIndexedPackage:(PLPackage *)package {
+    // Indexes are built from candidate versions, other versions of the same package and candidates whose entries haven't been updated yet have to read their own records
+    pkgCache::PkgIterator iterator = package.package;
+    if (iterator.Cache() != self->candidateCache || iterator->ID >= self->indexedVersions.size()) {
+        return NO;
+    }
+    return (pkgCache::Version *)package.verIterator == self->indexedVersions[iterator->ID];
+}
+
+- (std::shared_ptr<PLTagIndex>)tagIndexForPackage:(PLPackage *)package {
+    if (![self isIndexedPackage:package]) {
+        return std::shared_ptr<PLTagIndex>();
+    }
+    return std::atomic_load(&self->tagIndex);
+}
+
+- (std::shared_ptr<PLAuthorIndex>)authorIndex {
+    return std::atomic_load(&self->authorIndex);
+}
+
+- (std::shared_ptr<PLAuthorIndex>)authorIndexForPackage:(PLPackage *)package {
+    if (![self isIndexedPackage:package]) {
+        return std::shared_ptr<PLAuthorIndex>();
+    }
+    return std::atomic_load(&self->authorIndex);
+}
+
+- (std::shared_ptr<PLAuthorIndex>)maintainerIndex {
+    return std::atomic_load(&self->maintainerIndex);
+}
+
+- (std::shared_ptr<PLAuthorIndex>)maintainerIndexForPackage:(PLPackage *)package {
+    if (![self isIndexedPackage:package]) {
+        return std::shared_ptr<PLAuthorIndex>();
+    }
+    return std::atomic_load(&self->maintainerIndex);
+}
+
+- (std::shared_ptr<PLDescriptionStore>)descriptionStore {
+    return std::atomic_load(&self->descriptionStore);
+}
+
+- (std::shared_ptr<PLDescriptionStore>)descriptionStoreForPackage:(PLPackage *)package {
+    if (![self isIndexedPackage:package]) {
+        return std::shared_ptr<PLDescriptionStore>();
+    }
+    return std::atomic_load(&self->descriptionStore);
+}
+
+- (NSArray <PLPackage *> *)packagesAddedSince:(NSDate *)date {
+    std::shared_ptr<PLSnapshot> snapshot = std::atomic_load(&self->snapshot);
+    if (!snapshot) return @[];
+    
+    return [self packagesWithIDs:snapshot->packagesAddedSince((int64_t)date.timeIntervalSince1970)];
+}
+
+- (NSArray <PLPackage *> *)packagesUpdatedSince:(NSDate *)date {
+    std::shared_ptr<PLSnapshot> snapshot = std::atomic_load(&self->snapshot);
+    if (!snapshot) return @[];
+    
+    return [self packagesWithIDs:snapshot->packagesUpdatedSince((int64_t)date.timeIntervalSince1970)];
+}
+
+- (nullable NSDate *)firstSeenDateForPackage:(PLPackage *)package {
+    std::shared_ptr<PLSnapshot> snapshot = [self isIndexedPackage:package] ? std::atomic_load(&self->snapshot) : std::shared_ptr<PLSnapshot>();
+    if (!snapshot) return nil;
+    
+    PLSnapshot::Times times = snapshot->times(package.package->ID);
+    if (times.packageFirstSeen <= 0) return nil;
+    return [NSDate dateWithTimeIntervalSince1970:times.packageFirstSeen];
+}
+
+- (NSUInteger)descriptionStoreSize {
+    std::shared_ptr<PLDescriptionStore> descriptionStore = std::atomic_load(&self->descriptionStore);
+    return descriptionStore ? descriptionStore->memoryUsage() : 0;
+}
+
+- (NSArray <PLPackage *> *)packagesWithIDs:(std::vector<uint32_t> const &)packageIDs {
+    NSMutableArray *packages = [NSMutableArray arrayWithCapacity:packageIDs.size()];
+    for (uint32_t packageID : packageIDs) {
+        PLPackage *package = packageID < self->packagesByID.size() ? self->packagesByID[packageID] : nil;
         if (package) [packages addObject:package];
-        if (package.hasUpdate) [updates addObject:package];
     }
-    return @[packages, updates];
+    return packages;
+}
+
+- (NSArray <PLPackage *> *)packagesByPerson:(PLEmail *)person inIndex:(std::shared_ptr<PLAuthorIndex> const &)index field:(PLEmail * _Nullable (^)(PLPackage *package))field {
+    if (!person) return @[];
+    
+    if (!index) {
+        // The index is still being built, match the same way it would against every package
+        NSMutableArray *packages = [NSMutableArray new];
+        for (PLPackage *package in self.packages) {
+            PLEmail *other = field(package);
+            if (!other) continue;
+            
+            BOOL matches = person.email ? [other.email caseInsensitiveCompare:person.email] == NSOrderedSame : !other.email && [other.name compare:person.name options:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch] == NSOrderedSame;
+            if (matches) [packages addObject:package];
+        }
+        return packages;
+    }
+    
+    return [self packagesWithIDs:index->packages(person.name.UTF8String ?: "", person.email.UTF8String ?: "")];
+}
+
+- (NSArray <PLPackage *> *)packagesByAuthor:(PLEmail *)author {
+    return [self packagesByPerson:author inIndex:[self authorIndex] field:^PLEmail *(PLPackage *package) {
+        return package.author;
+    }];
+}
+
+- (NSArray <PLPackage *> *)packagesByMaintainer:(PLEmail *)maintainer {
+    return [self packagesByPerson:maintainer inIndex:[self maintainerIndex] field:^PLEmail *(PLPackage *package) {
+        return package.maintainer;
+    }];
+}
+
+- (NSArray <PLPackage *> *)dependencyClosureOfPackage:(PLPackage *)package downloadSize:(unsigned long long *)downloadSize {
+    NSAssert([NSThread isMainThread], @"Dependency closures have to be worked out on the main thread");
+    
+    pkgCache &packageCache = [self cache].GetDepCache()->GetCache();
+    pkgCache::VerIterator version = package.verIterator;
+    if (&packageCache != self->candidateCache || version.Cache() != self->candidateCache) {
+        if (downloadSize) *downloadSize = 0;
+        return @[];
+    }
+    
+    // Closures only hold for one candidate table, the memo is dropped whenever the indexes are rebuilt
+    if (!self->dependencyClosure) {
+        self->dependencyClosure = std::make_shared<PLDependencyClosure>(packageCache, self->candidateVersions);
+    }
+    std::shared_ptr<const PLDependencyClosure::Closure> closure = self->dependencyClosure->closure(version);
+    
+    map_id_t packageID = package.package->ID;
+    unsigned long long size = version.ParentPkg().CurrentVer() == version ? 0 : version->Size;
+    NSMutableArray *packages = [NSMutableArray arrayWithCapacity:closure->size()];
+    for (map_id_t dependencyID : *closure) {
+        if (dependencyID == packageID || dependencyID >= self->packagesByID.size()) continue;
+        
+        PLPackage *dependency = self->packagesByID[dependencyID];
+        if (!dependency) continue;
+        
+        size += dependency.verIterator->Size;
+        [packages addObject:dependency];
+    }
+    
+    if (downloadSize) *downloadSize = size;
+    return packages;
+}
+
+- (std::shared_ptr<PLReverseDependencyIndex>)reverseDependencyIndex {
+    pkgCache &packageCache = [self cache].GetDepCache()->GetCache();
+    if (&packageCache != self->candidateCache) return std::shared_ptr<PLReverseDependencyIndex>();
+    
+    // Installed versions only change with a new generation, so the index is built on first use and kept until the next import
+    if (!self->reverseDependencyIndex) {
+        self->reverseDependencyIndex = std::make_shared<PLReverseDependencyIndex>(packageCache);
+    }
+    return self->reverseDependencyIndex;
+}
+
+- (NSArray <PLPackage *> *)installedDependentsOfPackage:(PLPackage *)package {
+    std::shared_ptr<PLReverseDependencyIndex> index = [self reverseDependencyIndex];
+    if (!index || package.package.Cache() != self->candidateCache) return @[];
+    
+    NSMutableArray *dependents = [NSMutableArray new];
+    for (map_id_t packageID : index->dependents(package.package->ID)) {
+        PLPackage *dependent = packageID < self->packagesByID.size() ? self->packagesByID[packageID] : nil;
+        if (dependent) [dependents addObject:dependent];
+    }
+    return dependents;
+}
+
+- (NSArray <PLPackage *> *)removalImpactOfPackages:(NSArray <PLPackage *> *)packages {
+    std::shared_ptr<PLReverseDependencyIndex> index = [self reverseDependencyIndex];
+    if (!index) return @[];
+    
+    std::vector<map_id_t> packageIDs;
+    for (PLPackage *package in packages) {
+        if (package.package.Cache() == self->candidateCache) packageIDs.push_back(package.package->ID);
+    }
+    return [self packagesInSet:index->removalImpact(packageIDs)];
+}
+
+- (std::shared_ptr<PLProvidesIndex>)providesIndex {
+    pkgCache &packageCache = [self cache].GetDepCache()->GetCache();
+    if (&packageCache != self->candidateCache) return std::shared_ptr<PLProvidesIndex>();
+    
+    if (!self->providesIndex) {
+        self->providesIndex = std::make_shared<PLProvidesIndex>(packageCache);
+    }
+    return self->providesIndex;
+}
+
+- (PLPackage *)packageForProvider:(PLProvidesIndex::Provider const &)provider {
+    pkgDepCache *depCache = [self cache].GetDepCache();
+    pkgCache::VerIterator version(depCache->GetCache(), provider.version);
+    
+    // Reuse the shared package object when the candidate is the provider
+    PLPackage *package = [self packageForIterator:version.ParentPkg()];
+    if (package && (pkgCache::Version *)package.verIterator == provider.version) return package;
+    return [[PLPackage alloc] initWithIterator:version depCache:depCache records:self->records];
+}
+
+- (NSArray <PLPackage *> *)providersOfVirtualPackage:(NSString *)name {
+    std::shared_ptr<PLProvidesIndex> index = [self providesIndex];
+    if (!index) return @[];
+    
+    pkgCache::PkgIterator iterator = [self cache].GetDepCache()->GetCache().FindPkg(name.UTF8String);
+    if (iterator.end()) return @[];
+    
+    auto range = index->providers(iterator->ID);
+    NSMutableArray *providers = [NSMutableArray arrayWithCapacity:range.second - range.first];
+    for (auto provider = range.first; provider != range.second; provider++) {
+        PLPackage *package = [self packageForProvider:*provider];
+        if (package) [providers addObject:package];
+    }
+    return providers;
+}
+
+- (nullable PLPackage *)installedProviderOfVirtualPackage:(NSString *)name {
+    std::shared_ptr<PLProvidesIndex> index = [self providesIndex];
+    if (!index) return nil;
+    
+    pkgCache::PkgIterator iterator = [self cache].GetDepCache()->GetCache().FindPkg(name.UTF8String);
+    if (iterator.end()) return nil;
+    
+    auto range = index->providers(iterator->ID);
+    if (range.first == range.second || !range.first->installed) return nil;
+    return [self packageForProvider:*range.first];
+}
+
+- (NSArray <PLPackage *> *)packagesInSet:(PLBitset const &)set {
+    NSMutableArray *packages = [NSMutableArray arrayWithCapacity:set.count()];
+    set.forEach([&](size_t packageID) {
+        PLPackage *package = packageID < self->packagesByID.size() ? self->packagesByID[packageID] : nil;
+        if (package) [packages addObject:package];
+    });
+    return packages;
+}
+
+- (NSArray <PLPackage *> *)packagesWithRoleMask:(NSUInteger)roleMask includingTags:(nullable NSArray <NSString *> *)includedTags excludingTags:(nullable NSArray <NSString *> *)excludedTags {
+    std::shared_ptr<PLTagIndex> tagIndex = [self tagIndex];
+    if (!tagIndex) {
+        // The index is still being built, read each package's own tags rather than waiting for it
+        NSMutableArray *packages = [NSMutableArray new];
+        for (PLPackage *package in self.packages) {
+            if (!(roleMask & (1 << package.roleValue))) continue;
+            
+            BOOL matches = YES;
+            for (NSString *tag in includedTags) {
+                if (![package hasTag:tag]) matches = NO;
+            }
+            for (NSString *tag in excludedTags) {
+                if ([package hasTag:tag]) matches = NO;
+            }
+            if (matches) [packages addObject:package];
+        }
+        return packages;
+    }
+    
+    PLBitset result = tagIndex->packagesWithRoles((uint32_t)roleMask);
+    for (NSString *tag in includedTags) {
+        const PLBitset *tagged = tagIndex->packagesWithTag(tag.UTF8String);
+        if (!tagged) return @[];
+        result &= *tagged;
+    }
+    for (NSString *tag in excludedTags) {
+        const PLBitset *tagged = tagIndex->packagesWithTag(tag.UTF8String);
+        if (tagged) result.subtract(*tagged);
+    }
+    return [self packagesInSet:result];
+}
+
+#pragma mark - Updates
+
+- (BOOL)packageHasUpdate:(PLPackage *)package {
+    pkgCache::PkgIterator iterator = package.package;
+    if ([self isPackageHeld:package]) {
+        return NO;
+    }
+    pkgCache::VerIterator currentVersion = iterator.CurrentVer();
+    if (!currentVersion.end()) {
+        return currentVersion != package.verIterator;
+    }
+    return NO;
+}
+
+/*!
+ Bring the update state of some packages up to date without posting anything.
+ 
+ - returns: The user info of `PLPackageUpdatesChangeNotification`, with empty `added` and `removed` arrays if no package changed.
+ */
+- (NSDictionary *)applyUpdatesForPackages:(NSArray <PLPackage *> *)packages {
+    NSMutableArray *added = [NSMutableArray new];
+    NSMutableArray *removed = [NSMutableArray new];
+    for (PLPackage *package in packages) {
+        map_id_t packageID = package.package->ID;
+        if (packageID >= self->updatesSet.size()) continue;
+        
+        // A package that has lost its candidate can't have an update, it is reported as removed with the object that was passed in
+        PLPackage *tracked = packageID < self->packagesByID.size() ? self->packagesByID[packageID] : nil;
+        BOOL hasUpdate = tracked && [self packageHasUpdate:tracked];
+        if (hasUpdate == self->updatesSet.test(packageID)) continue;
+        
+        self->updatesSet.set(packageID, hasUpdate);
+        [hasUpdate ? added : removed addObject:tracked ?: package];
+    }
+    
+    if (added.count > 0 || removed.count > 0) self->updates = nil;
+    return @{@"count": @(self->updatesSet.count()), @"added": added, @"removed": removed};
+}
+
+- (void)refreshUpdatesForPackages:(NSArray <PLPackage *> *)packages {
+    NSDictionary *userInfo = [self applyUpdatesForPackages:packages];
+    if ([userInfo[@"added"] count] == 0 && [userInfo[@"removed"] count] == 0) return;
+    
+    [[NSNotificationCenter defaultCenter] postNotificationName:PLPackageUpdatesChangeNotification object:nil userInfo:userInfo];
+}
+
+#pragma mark - Candidates
+
+- (pkgCache::VerIterator)candidateForPackageIterator:(pkgCache::PkgIterator const &)iterator {
+    if (iterator.Cache() == self->candidateCache && iterator->ID < self->candidateVersions.size()) {
+        return pkgCache::VerIterator(*self->candidateCache, self->candidateVersions[iterator->ID]);
+    }
+    return cache->GetDepCache()->GetPolicy().GetCandidateVer(iterator);
+}
+
+- (nullable PLPackage *)packageForIterator:(pkgCache::PkgIterator const &)iterator {
+    if (iterator.Cache() != self->candidateCache || iterator->ID >= self->packagesByID.size()) {
+        return nil;
+    }
+    return self->packagesByID[iterator->ID];
+}
+
+- (std::vector<pkgCache::Version *>)candidateVersions {
+    if (&[self cache].GetDepCache()->GetCache() != self->candidateCache) return {};
+    return self->candidateVersions;
+}
+
+- (NSUInteger)policyGeneration {
+    return self->policyGeneration;
+}
+
+- (NSUInteger)cacheGeneration {
+    return self->cacheGeneration;
+}
+
+- (void)recomputeCandidatesForPackageIDs:(std::vector<map_id_t> const &)packageIDs {
+    pkgDepCache *depCache = cache->GetDepCache();
+    pkgCache &packageCache = depCache->GetCache();
+    if (&packageCache != self->candidateCache) return;
+    
+    NSMutableArray *changed = [NSMutableArray new];
+    NSMutableArray *lost = [NSMutableArray new];
+    NSMutableArray *gained = [NSMutableArray new];
+    std::vector<map_id_t> changedIDs;
+    PLBitset changedSet(self->packagesByID.size());
+    for (map_id_t packageID : packageIDs) {
+        if (packageID >= self->candidateVersions.size()) continue;
+        
+        pkgCache::PkgIterator iterator(packageCache, packageCache.PkgP + packageID);
+        pkgCache::VerIterator candidate = depCache->GetPolicy().GetCandidateVer(iterator);
+        pkgCache::Version *version = candidate.end() ? NULL : (pkgCache::Version *)candidate;
+        if (version == self->candidateVersions[packageID]) continue;
+        
+        self->candidateVersions[packageID] = version;
+        if (version) {
+            depCache->SetCandidateVersion(candidate);
+        } else {
+            // Without a policy candidate the package can only be kept, the depcache must not install the old one from the queue
+            depCache->MarkKeep(iterator, false, false);
+            pkgDepCache::StateCache &state = (*depCache)[iterator];
+            state.CandidateVer = NULL;
+            state.Update(iterator, packageCache);
+        }
+        
+        PLPackage *previous = self->packagesByID[packageID];
+        PLPackage *package = [[PLPackage alloc] initWithIterator:candidate depCache:depCache records:self->records];
+        self->packagesByID[packageID] = package;
+        changedIDs.push_back(packageID);
+        changedSet.set(packageID);
+        if (package) {
+            [changed addObject:package];
+            if (!previous) [gained addObject:package];
+        } else if (previous) {
+            [lost addObject:previous];
+        }
+    }
+    
+    if (changedIDs.empty()) return;
+    
+    self->policyGeneration++;
+    
+    // Swap the changed entries in place so that the order callers see doesn't change
+    NSMutableArray *packages = [self->packages mutableCopy];
+    NSMutableIndexSet *removedIndexes = [NSMutableIndexSet new];
+    for (NSUInteger i = 0; i < packages.count; i++) {
+        map_id_t packageID = ((PLPackage *)packages[i]).package->ID;
+        if (!changedSet.test(packageID)) continue;
+        
+        PLPackage *package = self->packagesByID[packageID];
+        if (package) {
+            packages[i] = package;
+        } else {
+            [removedIndexes addIndex:i];
+        }
+    }
+    [packages removeObjectsAtIndexes:removedIndexes];
+    [packages addObjectsFromArray:gained];
+    self->packages = packages;
+    self->_sections = nil;
+    self->dependencyClosure.reset();
+    
+    // A new candidate may carry different tags, only those entries are replaced and the snapshot is left alone since nothing new entered the catalog
+    [self updateIndexesForPackageIDs:changedIDs];
+    
+    // The packages that used to be in the update set were replaced above so the cached array has to be rebuilt either way.
+    self->updates = nil;
+    [self refreshUpdatesForPackages:[changed arrayByAddingObjectsFromArray:lost]];
+    
+    NSMutableArray *lostIdentifiers = [NSMutableArray arrayWithCapacity:lost.count];
+    for (PLPackage *package in lost) {
+        [lostIdentifiers addObject:package.identifier];
+    }
+    for (PLLiveQuery *query in self->liveQueries.allObjects) {
+        [query updateWithChangedPackages:changed removedIdentifiers:lostIdentifiers packageProvider:nil];
+    }
+}
+
+- (void)setPin:(short)pin forSource:(PLSource *)source {
+    pkgPolicy *policy = cache->GetPolicy();
+    pkgCache &packageCache = cache->GetDepCache()->GetCache();
+    pkgCache::RlsFileIterator releaseFile = source.index->FindInCache(packageCache, false);
+    if (!policy || releaseFile.end()) return;
+    
+    for (pkgCache::PkgFileIterator file = packageCache.FileBegin(); !file.end(); file++) {
+        if (file.ReleaseFile() == releaseFile) {
+            policy->SetPriority(file, pin);
+        }
+    }
+    
+    if (self->releasePackageIDs.empty()) {
+        // Versions don't link back to the files they come from, map every release file to the packages it offers once per generation
+        for (pkgCache::PkgIterator iterator = packageCache.PkgBegin(); !iterator.end(); iterator++) {
+            for (pkgCache::VerIterator version = iterator.VersionList(); !version.end(); version++) {
+                for (pkgCache::VerFileIterator verFile = version.FileList(); !verFile.end(); verFile++) {
+                    pkgCache::RlsFileIterator release = verFile.File().ReleaseFile();
+                    if (release.end()) continue;
+                    
+                    std::vector<map_id_t> &packageIDs = self->releasePackageIDs[release->ID];
+                    if (packageIDs.empty() || packageIDs.back() != iterator->ID) {
+                        packageIDs.push_back(iterator->ID);
+                    }
+                }
+            }
+        }
+    }
+    
+    auto packageIDs = self->releasePackageIDs.find(releaseFile->ID);
+    if (packageIDs != self->releasePackageIDs.end()) {
+        [self recomputeCandidatesForPackageIDs:packageIDs->second];
+    }
+}
+
+- (void)setPin:(short)pin forPackage:(PLPackage *)package {
+    pkgPolicy *policy = cache->GetPolicy();
+    if (!policy) return;
+    
+    policy->SetPriority(package.verIterator, pin);
+    [self recomputeCandidatesForPackageIDs:std::vector<map_id_t>{package.package->ID}];
+}
+
+- (BOOL)isPackageHeld:(PLPackage *)package {
+    pkgCache::PkgIterator iterator = package.package;
+    if (iterator->ID < self->heldSet.size()) {
+        return self->heldSet.test(iterator->ID);
+    }
+    return iterator->SelectedState == pkgCache::State::Hold;
 }
 
 - (NSArray <PLPackage *> *)packages {
@@ -277,6 +1113,14 @@ public:
 }
 
 - (NSArray <PLPackage *> *)updates {
+    if (!self->updates && !self->packagesByID.empty()) {
+        NSMutableArray *updates = [NSMutableArray arrayWithCapacity:self->updatesSet.count()];
+        self->updatesSet.forEach([&](size_t packageID) {
+            PLPackage *package = self->packagesByID[packageID];
+            if (package) [updates addObject:package];
+        });
+        self->updates = updates;
+    }
     return self->updates;
 }
 
@@ -320,12 +1164,121 @@ public:
     [self fetchPackagesInSource:nil matchingFilter:filter completion:completion];
 }
 
+- (NSDictionary <NSString *, NSArray *> *)valuesForFields:(NSArray <NSString *> *)fields ofPackages:(NSArray <PLPackage *> *)packages {
+    NSMutableDictionary *columns = [NSMutableDictionary dictionaryWithCapacity:fields.count];
+    for (NSString *field in fields) {
+        columns[field] = [NSMutableArray arrayWithCapacity:packages.count];
+    }
+    
+    std::vector<pkgCache::VerIterator> versions;
+    versions.reserve(packages.count);
+    for (PLPackage *package in packages) {
+        versions.push_back(package.verIterator);
+    }
+    
+    std::vector<std::shared_ptr<const PLRecordCache::Record>> records;
+    std::shared_ptr<PLRecordCache> recordCache = self->recordCache;
+    if (recordCache) {
+        records = recordCache->lookup(versions);
+    }
+    
+    // Resolve each field to its slot once rather than for every record
+    std::vector<std::string> keys;
+    std::vector<int> slots;
+    for (NSString *field in fields) {
+        keys.push_back(field.UTF8String);
+        slots.push_back(PLRecordCache::Record::slot(keys.back().c_str(), keys.back().size()));
+    }
+    
+    NSUInteger index = 0;
+    for (PLPackage *package in packages) {
+        const PLRecordCache::Record *record = index < records.size() ? records[index].get() : nullptr;
+        for (NSUInteger i = 0; i < fields.count; i++) {
+            id value = nil;
+            if (record) {
+                const char *start;
+                size_t length;
+                if (record->find(slots[i], keys[i].c_str(), keys[i].size(), start, length) && length > 0) {
+                    value = [[NSString alloc] initWithBytes:start length:length encoding:NSUTF8StringEncoding];
+                }
+            } else if (!recordCache || !recordCache->owns(package.verIterator)) {
+                // Packages from a previous generation can't use the current cache
+                value = [package getField:fields[i]];
+            }
+            [columns[fields[i]] addObject:value ?: [NSNull null]];
+        }
+        index++;
+    }
+    return columns;
+}
+
+- (void)prefetchRecordsForPackages:(NSArray <PLPackage *> *)packages inRange:(NSRange)range {
+    std::shared_ptr<PLRecordCache> recordCache = self->recordCache;
+    if (!recordCache || range.location >= packages.count) return;
+    
+    NSUInteger end = MIN(NSMaxRange(range), packages.count);
+    std::vector<pkgCache::VerIterator> versions;
+    versions.reserve(end - range.location);
+    for (NSUInteger i = range.location; i < end; i++) {
+        pkgCache::VerIterator version = packages[i].verIterator;
+        if (recordCache->owns(version) && !recordCache->contains(version)) {
+            versions.push_back(version);
+        }
+    }
+    if (versions.empty()) return;
+    
+    NSUInteger request = ++self->prefetchRequest;
+    dispatch_async(self->prefetchQueue, ^{
+        recordCache->prefetch(versions, [&]() {
+            return self->prefetchRequest == request;
+        });
+    });
+}
+
+/*!
+ Whether the file systems holding the archive cache and the installed files have room for the queue.
+ 
+ - parameter fetcher: The fetcher the archives have been queued on.
+ - parameter message: Set to a description of which file system is short on space when there isn't enough.
+ - returns: `NO` if either file system is known to be too small, `YES` otherwise or if the free space can't be read.
+ */
+- (BOOL)hasFreeSpaceForFetcher:(pkgAcquire *)fetcher message:(NSString **)message {
+    struct statvfs info;
+    
+    unsigned long long fetchBytes = fetcher->FetchNeeded() - fetcher->PartialPresent();
+    std::string archives = _config->FindDir("Dir::Cache::Archives");
+    if (fetchBytes > 0 && statvfs(archives.c_str(), &info) == 0 && (unsigned long long)info.f_bavail * info.f_frsize < fetchBytes) {
+        *message = [NSString stringWithFormat:@"Not enough free space in %s to download %llu bytes.", archives.c_str(), fetchBytes];
+        return NO;
+    }
+    
+    long long installBytes = self->cache->GetDepCache()->UsrSize();
+    std::string root = _config->FindDir("Dir");
+    if (installBytes > 0 && statvfs(root.c_str(), &info) == 0 && (unsigned long long)info.f_bavail * info.f_frsize < (unsigned long long)installBytes) {
+        *message = [NSString stringWithFormat:@"Not enough free space in %s to install %lld bytes.", root.c_str(), installBytes];
+        return NO;
+    }
+    
+    return YES;
+}
+
 - (void)downloadAndPerform:(id<PLConsoleDelegate>)delegate {
     self->status = new PLDownloadStatus(delegate);
     pkgAcquire *fetcher = new pkgAcquire(self->status);
     
     pkgPackageManager *manager = _system->CreatePM(self->cache->GetDepCache());
     manager->GetArchives(fetcher, cache->GetSourceList(), self->records);
+    
+    // Running out of space halfway through dpkg is far worse than not starting at all
+    NSString *spaceMessage = nil;
+    if (![self hasFreeSpaceForFetcher:fetcher message:&spaceMessage]) {
+        [delegate statusUpdate:spaceMessage atLevel:PLLogLevelError];
+        [delegate finishedDownloads];
+        [delegate finishedInstalls];
+        delete manager;
+        delete fetcher;
+        return;
+    }
 
     dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
         if (fetcher->TotalNeeded() > 0) {
@@ -551,6 +1504,16 @@ public:
 
 - (void)searchForPackagesWithDescription:(NSString *)description completion:(void (^)(NSArray <PLPackage *> *packages))completion {
     dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        std::shared_ptr<PLDescriptionStore> descriptionStore = [self descriptionStore];
+        if (descriptionStore) {
+            std::vector<uint32_t> packageIDs = descriptionStore->search([&](uint32_t packageID, const char *shortDescription, size_t length) {
+                NSString *candidate = [[NSString alloc] initWithBytesNoCopy:(void *)shortDescription length:length encoding:NSUTF8StringEncoding freeWhenDone:NO];
+                return candidate && [candidate rangeOfString:description options:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch].location != NSNotFound;
+            });
+            completion([self packagesWithIDs:packageIDs]);
+            return;
+        }
+        
         NSArray *searchResults = [self.packages filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"self.shortDescription CONTAINS[cd] %@", description]];
 
         completion(searchResults);
@@ -559,9 +1522,16 @@ public:
 
 - (void)searchForPackagesWithAuthorName:(NSString *)authorName completion:(void (^)(NSArray <PLPackage *> *packages))completion {
     dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
-        NSArray *searchResults = [self.packages filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"self.authorName CONTAINS[cd] %@", authorName]];
-
-        completion(searchResults);
+        std::shared_ptr<PLAuthorIndex> authorIndex = [self authorIndex];
+        if (!authorIndex) {
+            NSArray *searchResults = [self.packages filteredArrayUsingPredicate:[NSPredicate predicateWithFormat:@"self.author.name CONTAINS[cd] %@", authorName]];
+            
+            completion(searchResults);
+            return;
+        }
+        
+        std::vector<uint32_t> packageIDs = authorIndex->search(PLAuthorIndex::fold(authorName.UTF8String));
+        completion([self packagesWithIDs:packageIDs]);
     });
 }
 
@@ -576,7 +1546,13 @@ public:
 - (nullable PLPackage *)packageWithIdentifier:(NSString *)identifier {
     pkgDepCache *depCache = cache->GetDepCache();
     pkgCache::PkgIterator iterator = depCache->FindPkg(identifier.UTF8String, "any");
-    pkgCache::VerIterator verIterator = depCache->GetPolicy().GetCandidateVer(iterator);
+    if (iterator.end()) return NULL;
+    
+    if (iterator.Cache() == self->candidateCache && iterator->ID < self->packagesByID.size()) {
+        return self->packagesByID[iterator->ID];
+    }
+    
+    pkgCache::VerIterator verIterator = [self candidateForPackageIterator:iterator];
     return [[PLPackage alloc] initWithIterator:verIterator depCache:depCache records:self->records];
 }
 
@@ -631,38 +1607,60 @@ public:
 
     pkgDepCache *depCache = temporaryCache->GetDepCache();
     pkgRecords *records = new pkgRecords(*depCache);
-    NSArray *import = [self packagesAndUpdatesFromDepCache:depCache];
-
-    self->packages = import[0];
-    self->updates = import[1];
+    self->records = records;
+    [self importPackagesFromDepCache:depCache];
 
+    [self waitForCacheReaders];
     cache->Close();
     self->cache = temporaryCache;
     resolver = new pkgProblemResolver(*self->cache);
+    [self rebuildIndexes];
 
     pkgCache::PkgIterator itr = cache->GetDepCache()->FindPkg(packageIdentifier, architecture);
 
-    [[NSNotificationCenter defaultCenter] postNotificationName:PLDatabaseRefreshNotification object:nil userInfo:@{@"count": @(self->updates.count)}];
+    [self postDatabaseRefreshNotification];
     return [[PLPackage alloc] initWithIterator:depCache->GetCandidateVersion(itr) depCache:depCache records:records];
 }
 
 - (void)setPackage:(PLPackage *)package held:(BOOL)held {
-    NSMutableArray *mutableUpdates = [updates mutableCopy];
-    
+    [self setPackages:@[package] held:held];
+}
+
+- (BOOL)setPackages:(NSArray <PLPackage *> *)packages held:(BOOL)held {
+    // Every selection goes through a single dpkg --set-selections run
     APT::StateChanges states;
-    if (held) { // Hold package
-        states.Hold(package.verIterator);
-        
-        [mutableUpdates removeObject:package];
-    } else if (!held) { // Release package
-        states.Unhold(package.verIterator);
+    NSMutableArray *changed = [NSMutableArray arrayWithCapacity:packages.count];
+    for (PLPackage *package in packages) {
+        if ([self isPackageHeld:package] == held) continue;
         
-        if ([package hasUpdate]) [mutableUpdates addObject:package];
+        if (held) { // Hold package
+            states.Hold(package.verIterator);
+        } else { // Release package
+            states.Unhold(package.verIterator);
+        }
+        [changed addObject:package];
     }
-    states.Save();
     
-    self->updates = mutableUpdates;
-    [[NSNotificationCenter defaultCenter] postNotificationName:PLDatabaseRefreshNotification object:nil userInfo:@{@"count": @(self->updates.count)}];
+    // The held set only follows dpkg once the selections have actually been written
+    BOOL saved = changed.count == 0 || states.Save();
+    if (saved) {
+        for (PLPackage *package in changed) {
+            self->heldSet.set(package.package->ID, held);
+        }
+    } else {
+        [changed removeAllObjects];
+    }
+    
+    NSDictionary *userInfo = [self applyUpdatesForPackages:changed];
+    [[NSNotificationCenter defaultCenter] postNotificationName:PLPackageUpdatesChangeNotification object:nil userInfo:userInfo];
+    
+    NSMutableArray *tracked = [NSMutableArray arrayWithCapacity:changed.count];
+    for (PLPackage *package in changed) {
+        PLPackage *trackedPackage = [self packageWithIdentifier:package.identifier];
+        if (trackedPackage) [tracked addObject:trackedPackage];
+    }
+    if (tracked.count > 0) [self updateLiveQueriesWithChangedPackages:tracked];
+    return saved;
 }
 
 @end
@@ -167,14 +167,13 @@ extern char **environ;
 
 - (NSArray <PLPackage *> *)packagesForSource:(PLSource *)source {
     pkgCacheFile *cache = &[PLPackageManager sharedInstance].cache;
-    pkgDepCache *depCache = cache->GetDepCache();
-    pkgRecords *records = [PLPackageManager sharedInstance].records;
     pkgCache::RlsFileIterator releaseFile = source.index->FindInCache(*cache, false);
 
+    // Packages are already created from the shared candidate table, so there is no need to evaluate pins again here
     NSMutableArray <PLPackage *> *packages = [NSMutableArray array];
-    for (pkgCache::PkgIterator iterator = depCache->PkgBegin(); !iterator.end(); iterator++) {
-        pkgCache::VerIterator verIterator = depCache->GetPolicy().GetCandidateVer(iterator);
-        if (verIterator.end()) {
+    for (PLPackage *package in self->packageManager.packages) {
+        pkgCache::VerIterator verIterator = package.verIterator;
+        if (verIterator.FileList().end()) {
             continue;
         }
 
@@ -184,7 +183,7 @@ extern char **environ;
         }
 
         if (fileItr.ReleaseFile().FileName() == releaseFile.FileName()) {
-            [packages addObject:[[PLPackage alloc] initWithIterator:verIterator depCache:depCache records:records]];
+            [packages addObject:package];
         }
     }
     return packages;
@@ -0,0 +1,57 @@
+//
+//  PLLiveQuery.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import <Foundation/Foundation.h>
+
+@class PLPackage;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ A standing query over the package database whose results are kept up to date by `PLPackageManager`.
+
+ After every import only the packages that were added, removed or changed since the previous generation are re-checked against the predicate, and the update handler is called with the difference.
+ */
+NS_SWIFT_NAME(LiveQuery)
+@interface PLLiveQuery : NSObject
+
+/*!
+ Create a live query. The query is evaluated once it is registered with `-[PLPackageManager registerLiveQuery:]`.
+
+ - parameter predicate: Returns whether or not a package belongs in the results. It should only depend on the package itself.
+ - parameter updateHandler: Called whenever the results change with the packages that were inserted, the identifiers of the packages that were removed and the packages that still match but were replaced by a newer generation.
+ */
+- (instancetype)initWithPredicate:(BOOL (^)(PLPackage *package))predicate updateHandler:(void (^)(NSArray <PLPackage *> *inserted, NSArray <NSString *> *removed, NSArray <PLPackage *> *updated))updateHandler NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*!
+ The packages that currently match the predicate, in no particular order.
+ */
+@property (nonatomic, readonly) NSArray <PLPackage *> *results;
+
+#pragma mark - Maintenance
+
+/*!
+ Evaluate the predicate against every package. Called by `PLPackageManager` when no change set is available.
+
+ - parameter packages: Every package in the current generation.
+ */
+- (void)reloadWithPackages:(NSArray <PLPackage *> *)packages;
+
+/*!
+ Re-check only the packages that changed. Called by `PLPackageManager` after an import or a hold or pin change.
+
+ - parameter changed: Packages that were added or whose state changed.
+ - parameter removed: Identifiers of packages that no longer exist.
+ - parameter provider: Returns the current package for an identifier, used to move unchanged results over to a new generation. Pass `NULL` if the generation has not changed.
+ */
+- (void)updateWithChangedPackages:(NSArray <PLPackage *> *)changed removedIdentifiers:(NSArray <NSString *> *)removed packageProvider:(nullable PLPackage * _Nullable (^)(NSString *identifier))provider;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,110 @@
+//
+//  PLLiveQuery.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLLiveQuery.h"
+
+#import "PLPackage.h"
+
+@implementation PLLiveQuery {
+    BOOL (^_predicate)(PLPackage *package);
+    void (^_updateHandler)(NSArray <PLPackage *> *inserted, NSArray <NSString *> *removed, NSArray <PLPackage *> *updated);
+    NSMutableDictionary <NSString *, PLPackage *> *_matches;
+}
+
+- (instancetype)initWithPredicate:(BOOL (^)(PLPackage *package))predicate updateHandler:(void (^)(NSArray <PLPackage *> *inserted, NSArray <NSString *> *removed, NSArray <PLPackage *> *updated))updateHandler {
+    self = [super init];
+
+    if (self) {
+        _predicate = [predicate copy];
+        _updateHandler = [updateHandler copy];
+        _matches = [NSMutableDictionary new];
+    }
+
+    return self;
+}
+
+- (NSArray <PLPackage *> *)results {
+    @synchronized (self) {
+        return _matches.allValues;
+    }
+}
+
+- (void)reloadWithPackages:(NSArray <PLPackage *> *)packages {
+    NSMutableArray *inserted = [NSMutableArray new];
+    NSMutableArray *removed = [NSMutableArray new];
+    NSMutableDictionary *matches = [NSMutableDictionary new];
+
+    @synchronized (self) {
+        for (PLPackage *package in packages) {
+            if (!_predicate(package)) continue;
+
+            matches[package.identifier] = package;
+            if (!_matches[package.identifier]) [inserted addObject:package];
+        }
+        for (NSString *identifier in _matches) {
+            if (!matches[identifier]) [removed addObject:identifier];
+        }
+        _matches = matches;
+    }
+
+    [self notifyInserted:inserted removed:removed updated:@[]];
+}
+
+- (void)updateWithChangedPackages:(NSArray <PLPackage *> *)changed removedIdentifiers:(NSArray <NSString *> *)removed packageProvider:(PLPackage * _Nullable (^)(NSString *identifier))provider {
+    NSMutableArray *insertedPackages = [NSMutableArray new];
+    NSMutableArray *removedIdentifiers = [NSMutableArray new];
+    NSMutableArray *updatedPackages = [NSMutableArray new];
+
+    @synchronized (self) {
+        for (NSString *identifier in removed) {
+            if (!_matches[identifier]) continue;
+
+            [_matches removeObjectForKey:identifier];
+            [removedIdentifiers addObject:identifier];
+        }
+
+        NSMutableSet *changedIdentifiers = [NSMutableSet setWithCapacity:changed.count];
+        for (PLPackage *package in changed) {
+            NSString *identifier = package.identifier;
+            [changedIdentifiers addObject:identifier];
+
+            BOOL matched = _matches[identifier] != nil;
+            if (_predicate(package)) {
+                _matches[identifier] = package;
+                [matched ? updatedPackages : insertedPackages addObject:package];
+            } else if (matched) {
+                [_matches removeObjectForKey:identifier];
+                [removedIdentifiers addObject:identifier];
+            }
+        }
+
+        // Unchanged results still match, they only need to point at the current generation
+        if (provider) {
+            for (NSString *identifier in _matches.allKeys) {
+                if ([changedIdentifiers containsObject:identifier]) continue;
+
+                PLPackage *package = provider(identifier);
+                if (package) {
+                    _matches[identifier] = package;
+                } else {
+                    [_matches removeObjectForKey:identifier];
+                    [removedIdentifiers addObject:identifier];
+                }
+            }
+        }
+    }
+
+    [self notifyInserted:insertedPackages removed:removedIdentifiers updated:updatedPackages];
+}
+
+- (void)notifyInserted:(NSArray *)inserted removed:(NSArray *)removed updated:(NSArray *)updated {
+    if (inserted.count == 0 && removed.count == 0 && updated.count == 0) return;
+
+    if (_updateHandler) _updateHandler(inserted, removed, updated);
+}
+
+@end
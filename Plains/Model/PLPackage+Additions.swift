@@ -127,7 +127,7 @@ public extension Package {
 
      Specified by the presence of the `cydia::commercial` tag.
      */
-    var isPaid: Bool       { tags.contains("cydia::commercial") }
+    var isPaid: Bool       { hasTag("cydia::commercial") }
 
     /**
      The role of a package.
@@ -143,16 +143,7 @@ public extension Package {
      If a package does not have a role, it is assigned a role of .user.
      */
     var role: PackageRole {
-        for tag in tags {
-            if let firstHalfRange = tag.range(of: "role::"),
-               firstHalfRange.lowerBound == tag.startIndex {
-                let lastHalf = tag[firstHalfRange.upperBound..<tag.endIndex]
-                if let value = PackageRole.allCases.first(where: { $0.value == lastHalf }) {
-                    return value
-                }
-            }
-        }
-        return .user
+        PackageRole(rawValue: __roleValue) ?? .user
     }
 
     /**
@@ -192,8 +192,30 @@ NS_SWIFT_NAME(Package)
  */
 @property (nonatomic, strong, readonly) NSString *version;
 
+/*!
+ The package's tags.
+
+ Specified by a package's `Tag` field.
+ */
 @property (nonatomic, strong, readonly) NSArray <NSString *> *tags;
 
+/*!
+ Whether or not the package has a specific tag.
+
+ Uses the interned tag index when it is available instead of splitting the `Tag` field.
+
+ - parameter tag: The tag to check for.
+ - returns: `true` if the package has `tag`, `false` otherwise.
+ */
+- (BOOL)hasTag:(NSString *)tag;
+
+/*!
+ The raw value of the package's `PLPackageRole`.
+
+ Specified by a `role::` prefixed tag in the package's `Tag` field.
+ */
+@property (nonatomic, readonly) NSInteger roleValue NS_REFINED_FOR_SWIFT;
+
 @end
 
 NS_ASSUME_NONNULL_END
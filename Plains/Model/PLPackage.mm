@@ -10,6 +10,10 @@
 #import "PLSourceManager.h"
 #import "PLSource.h"
 #import "PLConfig.h"
+#import "PLRecordCache.h"
+#import "PLTagIndex.h"
+#import "PLAuthorIndex.h"
+#import "PLDescriptionStore.h"
 #import "NSString+Plains.h"
 #import <Plains/Plains-Swift.h>
 
@@ -50,14 +54,7 @@
 #pragma mark - Versions
 
 - (BOOL)hasUpdate {
-    if (self.isHeld) {
-        return NO;
-    }
-    pkgCache::VerIterator currentVersion = _package.CurrentVer();
-    if (!currentVersion.end()) {
-        return currentVersion != _verIterator;
-    }
-    return NO;
+    return [[PLPackageManager sharedInstance] packageHasUpdate:self];
 }
 
 - (NSUInteger)numberOfVersions {
@@ -86,7 +83,7 @@
 }
 
 - (BOOL)isHeld {
-    return _package->SelectedState == pkgCache::State::Hold;
+    return [[PLPackageManager sharedInstance] isPackageHeld:self];
 }
 
 - (BOOL)isInstalled {
@@ -104,6 +101,20 @@
         return nil;
     }
 
+    std::shared_ptr<PLRecordCache> recordCache = [PLPackageManager sharedInstance].recordCache;
+    if (recordCache && recordCache->owns(_verIterator)) {
+        std::shared_ptr<const PLRecordCache::Record> record = recordCache->lookup(_verIterator);
+        if (!record) return nil;
+
+        const char *key = field.UTF8String;
+        const char *value;
+        size_t length;
+        if (!record->find(key, strlen(key), value, length) || length == 0) {
+            return nil;
+        }
+        return [[NSString alloc] initWithBytes:value length:length encoding:NSUTF8StringEncoding];
+    }
+
     pkgRecords::Parser &parser = _records->Lookup(itr);
     return [NSString plains_stringWithStdString:parser.RecordField(field.UTF8String)];
 }
@@ -116,16 +127,35 @@
     return _verIterator->InstalledSize;
 }
 
+- (nullable PLEmail *)emailForPackageInIndex:(std::shared_ptr<PLAuthorIndex> const &)index {
+    const PLAuthorIndex::Author *author = index->author(_package->ID);
+    if (!author) {
+        return nil;
+    }
+    NSString *email = author->email.empty() ? nil : [NSString plains_stringWithStdString:author->email];
+    return [[PLEmail alloc] initWithName:[NSString plains_stringWithStdString:author->name] email:email];
+}
+
 - (nullable PLEmail *)author {
     if (!_author) {
-        _author = [[PLEmail alloc] initWithRFC822Value:self[@"Author"]];
+        std::shared_ptr<PLAuthorIndex> authorIndex = [[PLPackageManager sharedInstance] authorIndexForPackage:self];
+        if (authorIndex) {
+            _author = [self emailForPackageInIndex:authorIndex];
+        } else {
+            _author = [[PLEmail alloc] initWithRFC822Value:self[@"Author"]];
+        }
     }
     return _author;
 }
 
 - (nullable PLEmail *)maintainer {
     if (!_maintainer) {
-        _maintainer = [[PLEmail alloc] initWithRFC822Value:self[@"Maintainer"]];
+        std::shared_ptr<PLAuthorIndex> maintainerIndex = [[PLPackageManager sharedInstance] maintainerIndexForPackage:self];
+        if (maintainerIndex) {
+            _maintainer = [self emailForPackageInIndex:maintainerIndex];
+        } else {
+            _maintainer = [[PLEmail alloc] initWithRFC822Value:self[@"Maintainer"]];
+        }
     }
     return _maintainer;
 }
@@ -152,18 +182,16 @@
 
 - (NSString *)longDescription {
     if (!_longDescription && !_verIterator.end()) {
-        pkgRecords::Parser & parser = _records->Lookup(_verIterator.FileList());
-        std::string description = parser.LongDesc();
-
-        NSString *longDesc = [NSString stringWithUTF8String:description.c_str()];
-        NSRange endOfFirstLine = [longDesc rangeOfString:@"\n"];
-        if (endOfFirstLine.location != NSNotFound) {
-            NSString *trimmed = [longDesc substringFromIndex:endOfFirstLine.location + 2];
-            trimmed = [trimmed stringByReplacingOccurrencesOfString:@"\n " withString:@"\n"];
-            _longDescription = [trimmed stringByReplacingOccurrencesOfString:@"\n.\n" withString:@"\n\n"];
-        } else {
-            _longDescription = longDesc;
+        std::shared_ptr<PLDescriptionStore> descriptionStore = [[PLPackageManager sharedInstance] descriptionStoreForPackage:self];
+        std::string shortDescription;
+        __block std::string description;
+        if (!descriptionStore || !descriptionStore->lookup(_package->ID, shortDescription, description)) {
+            [self withRecords:^(pkgRecords &records) {
+                pkgRecords::Parser &parser = records.Lookup(self->_verIterator.FileList());
+                description = PLDescriptionStore::formatLongDescription(parser.LongDesc());
+            }];
         }
+        _longDescription = [NSString plains_stringWithStdString:description];
     }
     return _longDescription;
 }
@@ -175,8 +203,15 @@
     pkgCache::VerFileIterator itr = _verIterator.FileList();
     if (itr.end()) return nil;
 
-    pkgRecords::Parser &parser = _records->Lookup(itr);
-    std::string description = parser.ShortDesc();
+    std::shared_ptr<PLDescriptionStore> descriptionStore = [[PLPackageManager sharedInstance] descriptionStoreForPackage:self];
+    std::string longDescription;
+    __block std::string description;
+    if (!descriptionStore || !descriptionStore->lookup(_package->ID, description, longDescription)) {
+        [self withRecords:^(pkgRecords &records) {
+            pkgRecords::Parser &parser = records.Lookup(itr);
+            description = parser.ShortDesc();
+        }];
+    }
     if (description.empty()) {
         return nil;
     }
@@ -193,14 +228,61 @@
 
 - (NSArray <NSString *> *)tags {
     if (!_tags) {
-        NSString *tags = self[@"Tag"];
-        _tags = tags ? [self _parseCommaSeparatedList:tags] : @[];
+        std::shared_ptr<PLTagIndex> tagIndex = [[PLPackageManager sharedInstance] tagIndexForPackage:self];
+        if (tagIndex) {
+            NSMutableArray *tags = [NSMutableArray array];
+            for (std::string const *tag : tagIndex->tags(_package->ID)) {
+                [tags addObject:[NSString stringWithUTF8String:tag->c_str()]];
+            }
+            _tags = tags;
+        } else {
+            NSString *tags = self[@"Tag"];
+            _tags = tags ? [self _parseCommaSeparatedList:tags] : @[];
+        }
     }
     return _tags;
 }
 
+- (BOOL)hasTag:(NSString *)tag {
+    std::shared_ptr<PLTagIndex> tagIndex = [[PLPackageManager sharedInstance] tagIndexForPackage:self];
+    if (tagIndex) {
+        const PLBitset *tagged = tagIndex->packagesWithTag(tag.UTF8String);
+        return tagged && tagged->test(_package->ID);
+    }
+    return [self.tags containsObject:tag];
+}
+
+- (NSInteger)roleValue {
+    std::shared_ptr<PLTagIndex> tagIndex = [[PLPackageManager sharedInstance] tagIndexForPackage:self];
+    if (tagIndex) {
+        return tagIndex->role(_package->ID);
+    }
+
+    NSArray *roles = @[@"user", @"enduser", @"hacker", @"developer", @"cydia"];
+    for (NSString *tag in self.tags) {
+        if (![tag hasPrefix:@"role::"]) continue;
+
+        NSUInteger role = [roles indexOfObject:[tag substringFromIndex:6]];
+        if (role != NSNotFound) {
+            return role;
+        }
+    }
+    return PLTagIndex::RoleUser;
+}
+
 #pragma mark - Helpers
 
+- (void)withRecords:(void (^)(pkgRecords &records))block {
+    std::shared_ptr<PLRecordCache> recordCache = [PLPackageManager sharedInstance].recordCache;
+    if (recordCache && recordCache->owns(_verIterator)) {
+        recordCache->withRecords([&](pkgRecords &records) {
+            block(records);
+        });
+    } else {
+        block(*_records);
+    }
+}
+
 - (NSArray <NSString *> *)_parseCommaSeparatedList:(NSString *)input {
     NSArray *items = [input componentsSeparatedByString:@","];
     NSMutableArray *result = [NSMutableArray array];
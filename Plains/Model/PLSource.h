@@ -32,6 +32,8 @@ NS_SWIFT_NAME(Source)
 
 /*!
  The current pin preference of this source.
+ 
+ A pin set here is applied to the current policy only and is not saved, it is reported until the next import.
  */
 @property (nonatomic) short defaultPin;
 
@@ -27,8 +27,12 @@ PL_APT_PKG_IMPORTS_END
 @implementation PLSource {
     NSDictionary <NSString *, NSNumber *> *_sections;
     PLTagFile *_tagSection;
+    BOOL _hasPinOverride;
+    NSUInteger _pinGeneration;
 }
 
+@synthesize defaultPin = _defaultPin;
+
 - (instancetype)initWithMetaIndex:(metaIndex *)index {
     self = [super init];
     
@@ -147,7 +151,20 @@ PL_APT_PKG_IMPORTS_END
 }
 
 - (short)defaultPin {
-    return _index->GetDefaultPin();
+    // The override only lives in the policy of the generation it was set in, the next import builds a new policy without it
+    if (_hasPinOverride && _pinGeneration != [PLPackageManager sharedInstance].cacheGeneration) {
+        _hasPinOverride = NO;
+    }
+    return _hasPinOverride ? _defaultPin : _index->GetDefaultPin();
+}
+
+- (void)setDefaultPin:(short)defaultPin {
+    _defaultPin = defaultPin;
+    _hasPinOverride = YES;
+    _pinGeneration = [PLPackageManager sharedInstance].cacheGeneration;
+    _sections = nil;
+
+    [[PLPackageManager sharedInstance] setPin:defaultPin forSource:self];
 }
 
 - (BOOL)isTrusted {
@@ -20,6 +20,8 @@ FOUNDATION_EXPORT const unsigned char PlainsVersionString[];
 #import <Plains/PLSourceManager.h>
 #import <Plains/PLPackage.h>
 #import <Plains/PLSource.h>
+#import <Plains/PLLiveQuery.h>
 #import <Plains/PLQueue.h>
+#import <Plains/PLTransactionPlan.h>
 #import <Plains/PLTagFile.h>
 #import <Plains/NSString+Plains.h>
@@ -9,11 +9,14 @@
 
 @class PLPackageManager;
 @class PLPackage;
+@class PLTransactionPlan;
 
 NS_ASSUME_NONNULL_BEGIN
 
 /*!
  Notification constant representing that the queue has been updated.
+ 
+ The `userInfo` dictionary contains the new `count` of queued packages along with `added` and `removed`, arrays indexed by `PLQueueType` that hold the identifiers of the packages that entered or left each queue since the previous notification. A package that moved between queues appears in both.
  */
 extern NSNotificationName const PLQueueUpdateNotification NS_SWIFT_NAME(PLQueue.queueDidUpdateNotification);
 
@@ -35,7 +38,8 @@ typedef NS_ENUM(NSUInteger, PLQueueType) {
 typedef NS_ENUM(NSUInteger, PLBrokenReason) {
     PLBrokenReasonNotFound,
     PLBrokenReasonAlreadyInstalled,
-    PLBrokenReasonUnknown
+    PLBrokenReasonUnknown,
+    PLBrokenReasonConflict
 };
 
 /*!
@@ -57,6 +61,8 @@ NS_SWIFT_NAME(Queue)
  A dictionary of issues that might have arisen due to different packages being queued together.
  
  Keys are package identifiers and the value is an array of dictionaries representing the problems.
+ 
+ Only the set of broken packages is tracked while the queue changes, the details are worked out the first time this is read after a change.
  */
 @property (nonatomic, readonly) NSDictionary <NSString *, NSArray *> *issues;
 
@@ -72,11 +78,40 @@ NS_SWIFT_NAME(Queue)
  */
 @property (nonatomic, readonly) NSUInteger count;
 
+/*!
+ The number of bytes that still have to be downloaded for the queued packages.
+ 
+ The totals are kept up to date as packages enter and leave the queue, only the packages whose marks changed are looked at again.
+ */
+@property (nonatomic, readonly) unsigned long long downloadSize;
+
+/*!
+ The number of bytes of queued archives that are already in the archive cache and won't be downloaded again.
+ */
+@property (nonatomic, readonly) unsigned long long cachedDownloadSize;
+
+/*!
+ How many bytes installing the queue will take up, negative if it frees space.
+ */
+@property (nonatomic, readonly) long long installedSizeChange;
+
 /*!
  Whether or not the queue currently has essential packages queued for removal.
  */
 @property (nonatomic, readonly) BOOL hasEssentialPackages;
 
+/*!
+ Installed packages that were only installed automatically and that nothing installed or queued depends on anymore.
+ 
+ libapt sweeps the auto-installed flags from the extended states every time the queue changes, this only keeps track of which packages were swept so the list is ready without walking any dependencies.
+ */
+@property (nonatomic, readonly) NSArray <PLPackage *> *unneededPackages;
+
+/*!
+ Queue every package in `unneededPackages` for removal in a single batch.
+ */
+- (void)queueUnneededPackages;
+
 /*!
  Queue a local package for installation.
  
@@ -92,6 +127,16 @@ NS_SWIFT_NAME(Queue)
  */
 - (void)addPackage:(PLPackage *)package toQueue:(PLQueueType)queue;
 
+/*!
+ Add several packages to the same queue at once.
+ 
+ Every package is marked inside a single action group and the resolver only runs once, which makes restoring a saved queue or upgrading everything much faster than adding packages one at a time. Dependencies that are pulled in are attributed to the package that depends on them so that `canRemovePackage:` and `removePackage:` behave as if each package had been added individually.
+ 
+ - parameter packages: The packages to be queued.
+ - parameter queue: The queue to add the packages to.
+ */
+- (void)addPackages:(NSArray <PLPackage *> *)packages toQueue:(PLQueueType)queue;
+
 /*!
  Whether or not a package can be removed from the queue.
  
@@ -113,6 +158,68 @@ NS_SWIFT_NAME(Queue)
  */
 - (void)clear;
 
+/*!
+ Whether or not there is a queue operation that can be undone.
+ */
+@property (nonatomic, readonly) BOOL canUndo;
+
+/*!
+ Whether or not there is an undone queue operation that can be redone.
+ */
+@property (nonatomic, readonly) BOOL canRedo;
+
+/*!
+ Undo the last add, remove or clear.
+ 
+ The mark state of every queued package is captured before each operation and restored directly, so the resolver does not run again and the result is exactly the queue as it was before.
+ */
+- (void)undo;
+
+/*!
+ Redo the last operation that was undone.
+ */
+- (void)redo;
+
+/*!
+ Check a package for conflicts with what is installed and queued before adding it to the queue.
+ 
+ This doesn't run the resolver, it compares the version's `Conflicts`, `Breaks` and `Depends` with the state the queue would leave the system in, along with the `Conflicts` and `Breaks` of installed and queued packages against the version and what it provides. It is meant to be fast enough to warn on an install button and can miss problems the resolver would find further down the dependency chain.
+ 
+ - parameter package: The package to check, at the version it represents.
+ - returns: An array of dictionaries in the same format as `issues`. Clashes use `PLBrokenReasonConflict` and name the other package under `package`, dependencies that nothing can satisfy use `PLBrokenReasonNotFound`.
+ */
+- (NSArray <NSDictionary *> *)conflictsForPackage:(PLPackage *)package NS_SWIFT_NAME(conflicts(for:));
+
+/*!
+ Compute what the queue would look like if packages were installed or removed, without changing the queue.
+ 
+ The current queue is copied onto a private dependency cache and the resolver runs there on a background thread, so several plans can be computed at the same time while the queue stays usable. The plan is discarded if the database is refreshed before it finishes.
+ 
+ - parameter install: Packages to install at the version each object represents.
+ - parameter remove: Packages to remove.
+ - parameter completion: Called on the main queue with the resulting plan, or `nil` if the database was refreshed in the meantime.
+ */
+- (void)planInstalling:(NSArray <PLPackage *> *)install removing:(NSArray <PLPackage *> *)remove completion:(void (^)(PLTransactionPlan * _Nullable plan))completion NS_SWIFT_NAME(plan(installing:removing:completion:));
+
+/*!
+ The packages that were queued directly by the user, keyed by identifier with the `PLQueueType` they were queued for.
+ 
+ This can be saved and later passed to `benchmarkSolvers:withScenarios:timeout:` to replay the same request.
+ */
+@property (nonatomic, readonly) NSDictionary <NSString *, NSNumber *> *scenario;
+
+/*!
+ Replay recorded queue scenarios against several solvers and report how each of them did.
+ 
+ The queue is resolved with the internal resolver unless `Plains::Solver` names an EDSP solver, which is then given `Plains::Solver::Timeout` seconds (10 by default) before the internal resolver takes over. This helps decide which to configure: each scenario is resolved from an empty queue on a private dependency cache once per solver, so the queue itself is left untouched. Blocks until every run has finished.
+ 
+ - parameter solvers: Names of EDSP solvers in `Dir::Bin::Solvers`, or `internal` for the built-in resolver.
+ - parameter scenarios: Scenarios previously recorded from `scenario`.
+ - parameter timeout: The number of seconds each external solver is given before falling back to the internal resolver.
+ - returns: One dictionary per scenario and solver with the `scenario` index, the `solver` name, the wall-clock `time` in seconds, the solution `size` as the number of packages that would be queued, whether it was `resolved`, whether the `external` solver's answer was used and whether it `timedOut`.
+ */
+- (NSArray <NSDictionary <NSString *, id> *> *)benchmarkSolvers:(NSArray <NSString *> *)solvers withScenarios:(NSArray <NSDictionary <NSString *, NSNumber *> *> *)scenarios timeout:(NSTimeInterval)timeout NS_SWIFT_NAME(benchmark(solvers:scenarios:timeout:));
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -8,21 +8,126 @@
 #import "PLQueue.h"
 
 #import <Plains/Plains.h>
+#import "PLBitset.h"
+#import "PLQueueMarks.h"
+#import "PLTransactionPlan.h"
+#import "PLSolver.h"
+#import "PLProvidesIndex.h"
+#import "PLReverseDependencyIndex.h"
 
 PL_APT_PKG_IMPORTS_BEGIN
 #import <apt-pkg/algorithms.h>
+#import <apt-pkg/configuration.h>
+#import <apt-pkg/error.h>
 #import <apt-pkg/indexfile.h>
+#import <apt-pkg/strutl.h>
 PL_APT_PKG_IMPORTS_END
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <utility>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
 NSNotificationName const PLQueueUpdateNotification = @"PLQueueUpdateNotification";
 
+/*!
+ Everything needed to put the queue back the way it was without running the resolver.
+ */
+struct PLQueueSnapshot {
+    NSUInteger generation;
+    std::vector<PLQueueMark> marks;
+    std::unordered_map<map_id_t, std::vector<map_id_t>> dependencies;
+};
+
+static const size_t PLQueueUndoLimit = 32;
+
+/*!
+ The solver named by `Plains::Solver`, `internal` unless an EDSP solver has been configured.
+ */
+static std::string PLQueueSolverName() {
+    return _config->Find("Plains::Solver", PLSolverInternal);
+}
+
+/*!
+ The wall-clock budget in seconds for an external solver, from `Plains::Solver::Timeout`.
+ */
+static double PLQueueSolverTimeout() {
+    return _config->FindI("Plains::Solver::Timeout", 10);
+}
+
+/*!
+ A single unsatisfied dependency of a broken package. Only bridged to a dictionary when `issues` is read.
+ */
+struct PLQueueIssue {
+    pkgCache::Dependency *dependency;
+    pkgCache::Version *installedTargetVersion;
+    PLBrokenReason reason;
+};
+
+/*!
+ What a single queued package adds to the queue's totals.
+ */
+struct PLQueueSizes {
+    unsigned long long download;
+    unsigned long long cached;
+    long long installed;
+};
+
+/*!
+ Whether the archive for a version has already been downloaded to `Dir::Cache::Archives`.
+ 
+ The name is built the same way `pkgAcqArchive` names the files it stores, assuming the usual `.deb` extension so the package records don't need to be read.
+ */
+static bool PLQueueIsArchiveCached(pkgCache::VerIterator const &version) {
+    std::string path = _config->FindDir("Dir::Cache::Archives");
+    path += QuoteString(version.ParentPkg().Name(), "_:") + '_' + QuoteString(version.VerStr(), "_:") + '_' + QuoteString(version.Arch(), "_:.") + ".deb";
+    
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && (unsigned long long)info.st_size == version->Size;
+}
+
+/*!
+ A depcache policy that hands out a fixed set of candidates, so that a private depcache sees the same candidates as the shared one without touching `pkgPolicy` from another thread.
+ */
+class PLCandidatePolicy : public pkgDepCache::Policy {
+public:
+    PLCandidatePolicy(pkgCache &cache, std::vector<pkgCache::Version *> candidates) : _cache(cache), _candidates(std::move(candidates)) {}
+
+    pkgCache::VerIterator GetCandidateVer(pkgCache::PkgIterator const &package) override {
+        if (package->ID >= _candidates.size()) return pkgCache::VerIterator(_cache);
+        return pkgCache::VerIterator(_cache, _candidates[package->ID]);
+    }
+
+private:
+    pkgCache &_cache;
+    std::vector<pkgCache::Version *> _candidates;
+};
+
 @implementation PLQueue {
     PLPackageManager *database;
-    NSMutableDictionary <NSString *, NSSet *> *enqueuedDependencies;
+    std::unordered_map<map_id_t, std::vector<map_id_t>> enqueuedDependencies;
+    std::unordered_map<std::string, PLQueueType> postedQueueTypes;
+    pkgCache *stateCache;
+    NSUInteger stateGeneration;
+    NSUInteger statePolicyGeneration;
+    BOOL statesDirty;
+    std::vector<uint8_t> packageStates;
+    std::set<map_id_t> queueMembers[PLQueueCount];
+    PLBitset brokenPackages;
+    PLBitset garbagePackages;
+    std::unordered_map<map_id_t, PLQueueSizes> queuedSizes;
+    std::vector<PLQueueSnapshot> undoStack;
+    std::vector<PLQueueSnapshot> redoStack;
 }
 
 @synthesize issues = _issues;
 @synthesize queuedPackages = _queuedPackages;
+@synthesize unneededPackages = _unneededPackages;
 
 + (instancetype)sharedInstance {
     static PLQueue *instance = nil;
@@ -38,7 +143,7 @@ NSNotificationName const PLQueueUpdateNotification = @"PLQueueUpdateNotification
     
     if (self) {
         database = [PLPackageManager sharedInstance];
-        enqueuedDependencies = [NSMutableDictionary new];
+        statesDirty = YES;
         
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(generatePackages) name:PLDatabaseRefreshNotification object:nil];
     }
@@ -47,87 +152,199 @@ NSNotificationName const PLQueueUpdateNotification = @"PLQueueUpdateNotification
 }
 
 - (void)generatePackages {
-    _hasEssentialPackages = NO;
+    pkgCacheFile &cache = database.cache;
+    pkgDepCache *depCache = cache.GetDepCache();
+    pkgCache *packageCache = &depCache->GetCache();
+    size_t packageCount = depCache->Head().PackageCount;
+    
+    BOOL changed = NO;
+    if (packageCache != stateCache || database.cacheGeneration != stateGeneration || packageStates.size() != packageCount || !_queuedPackages) {
+        // A new generation, nothing from the previous one can be reused even if the cache was mapped at the same address
+        stateCache = packageCache;
+        stateGeneration = database.cacheGeneration;
+        packageStates.assign(packageCount, PLQueueCount);
+        for (std::set<map_id_t> &members : queueMembers) {
+            members.clear();
+        }
+        brokenPackages = PLBitset(packageCount);
+        garbagePackages = PLBitset(packageCount);
+        _unneededPackages = nil;
+        queuedSizes.clear();
+        _downloadSize = 0;
+        _cachedDownloadSize = 0;
+        _installedSizeChange = 0;
+        _issues = nil;
+        enqueuedDependencies.clear();
+        undoStack.clear();
+        redoStack.clear();
+        changed = YES;
+        
+        // The garbage flags are swept again whenever an action group ends, so this is only needed once per generation
+        depCache->MarkAndSweep();
+    }
+    
+    // Only marks made through the queue and pin changes move the depcache, read-only callers skip the scan when neither happened
+    if (!changed && !statesDirty && database.policyGeneration == statePolicyGeneration) return;
+    statesDirty = NO;
+    statePolicyGeneration = database.policyGeneration;
+    
+    // Comparing one byte per package is far cheaper than rebuilding the lists, so only packages whose mark state changed are looked at any further
+    BOOL statesChanged = NO;
+    for (pkgCache::PkgIterator iterator = depCache->PkgBegin(); !iterator.end(); iterator++) {
+        uint8_t state = PLQueueStateForPackage(cache[iterator]);
+        uint8_t &previous = packageStates[iterator->ID];
+        if (state == previous) continue;
+        
+        PLPackage *package = [database packageForIterator:iterator];
+        if (package) {
+            uint8_t previousQueue = previous & ~PLQueueStateFlags;
+            uint8_t queue = state & ~PLQueueStateFlags;
+            if (previousQueue != queue) {
+                if (previousQueue < PLQueueCount) queueMembers[previousQueue].erase(iterator->ID);
+                if (queue < PLQueueCount) queueMembers[queue].insert(iterator->ID);
+                changed = YES;
+            }
+            brokenPackages.set(iterator->ID, state & PLQueueStateBroken);
+            if (garbagePackages.test(iterator->ID) != ((state & PLQueueStateUnneeded) != 0)) {
+                garbagePackages.set(iterator->ID, state & PLQueueStateUnneeded);
+                _unneededPackages = nil;
+            }
+            [self updateSizesForPackage:iterator queue:queue];
+        }
+        previous = state;
+        statesChanged = YES;
+    }
+    
+    // Any mark change can change why a package is broken, the details are worked out again the next time they're read
+    if (statesChanged) _issues = nil;
+    
+    if (!changed) return;
     
-    NSMutableArray *packages = [NSMutableArray arrayWithCapacity:PLQueueCount - 1];
-    NSMutableDictionary *issues = [NSMutableDictionary new];
+    _hasEssentialPackages = NO;
+    NSMutableArray *packages = [NSMutableArray arrayWithCapacity:PLQueueCount];
     for (NSUInteger i = 0; i < PLQueueCount; i++) {
-        packages[i] = [NSMutableArray new];
+        NSMutableArray *queue = [NSMutableArray arrayWithCapacity:queueMembers[i].size()];
+        for (map_id_t packageID : queueMembers[i]) {
+            PLPackage *package = [database packageForIterator:pkgCache::PkgIterator(*packageCache, packageCache->PkgP + packageID)];
+            if (!package) continue;
+            
+            if (i == PLQueueRemove && !_hasEssentialPackages && package.isEssential) _hasEssentialPackages = YES;
+            [queue addObject:package];
+        }
+        packages[i] = queue;
+    }
+    
+    _queuedPackages = packages;
+}
+
+- (void)updateSizesForPackage:(pkgCache::PkgIterator const &)iterator queue:(uint8_t)queue {
+    auto previous = queuedSizes.find(iterator->ID);
+    if (previous != queuedSizes.end()) {
+        _downloadSize -= previous->second.download;
+        _cachedDownloadSize -= previous->second.cached;
+        _installedSizeChange -= previous->second.installed;
+        queuedSizes.erase(previous);
     }
+    if (queue >= PLQueueCount) return;
+    
+    pkgCacheFile &cache = database.cache;
+    pkgCache::VerIterator current = iterator.CurrentVer();
+    pkgCache::VerIterator target = cache[iterator].InstVerIter(cache);
+    
+    PLQueueSizes sizes = {0, 0, 0};
+    if (!target.end()) {
+        sizes.installed += target->InstalledSize;
+        if (PLQueueIsArchiveCached(target)) {
+            sizes.cached = target->Size;
+        } else {
+            sizes.download = target->Size;
+        }
+    }
+    if (!current.end()) sizes.installed -= current->InstalledSize;
+    
+    _downloadSize += sizes.download;
+    _cachedDownloadSize += sizes.cached;
+    _installedSizeChange += sizes.installed;
+    queuedSizes[iterator->ID] = sizes;
+}
+
+- (std::vector<PLQueueIssue>)issuesForPackage:(pkgCache::PkgIterator const &)iterator {
+    std::vector<PLQueueIssue> issues;
     
     pkgCacheFile &cache = database.cache;
-    for (PLPackage *package in database.packages) {
-        pkgCache::PkgIterator iterator = package.package;
+    pkgCache::VerIterator installedVersionIterator = cache[iterator].InstVerIter(cache);
+    if (installedVersionIterator.end()) return issues;
+    
+    std::shared_ptr<PLProvidesIndex> providesIndex = [database providesIndex];
+    
+    pkgCache::DepIterator depIterator = installedVersionIterator.DependsList();
+    while (!depIterator.end()) {
+        pkgCache::DepIterator Start;
+        pkgCache::DepIterator End;
+        depIterator.GlobOr(Start, End); // Iterates over entire dependency group instead of just one dependency apparently the "more sensible" way to iterate, also increments depIterator.
         
-        if (cache[iterator].InstBroken()) {
-            pkgCache::VerIterator installedVersionIterator = cache[iterator].InstVerIter(cache);
-            if (installedVersionIterator.end()) continue;
-            
-            pkgCache::DepIterator depIterator = installedVersionIterator.DependsList();
-            while (!depIterator.end()) {
-                pkgCache::DepIterator Start;
-                pkgCache::DepIterator End;
-                depIterator.GlobOr(Start, End); // Iterates over entire dependency group instead of just one dependency apparently the "more sensible" way to iterate, also increments depIterator.
-                
-                if ((cache[End] & pkgDepCache::DepGInstall) != 0) continue; // Is this dependency actually broken?
-                
-                while (true) {
-                    PLBrokenReason reason;
-                    NSString *installedVersion;
-                    pkgCache::PkgIterator target = Start.TargetPkg();
-                    if (target->ProvidesList != NULL) { // Package cannot be found in current sources.
-                        reason = PLBrokenReasonNotFound;
-                    } else {
-                        pkgCache::VerIterator installedTargetVersion = cache[target].InstVerIter(cache);
-                        if (!installedTargetVersion.end()) { // The installed version is different than the required version (and is likely missing)
-                            reason = PLBrokenReasonAlreadyInstalled;
-                            installedVersion = [NSString stringWithUTF8String:installedTargetVersion.VerStr()];
-                        } else { // I'm sure there are other cases but I have no idea ATM
-                            reason = PLBrokenReasonUnknown;
-                        }
-                    }
-                    
-                    NSDictionary *issue = @{
-                        @"reason": @(reason),
-                        @"relationship": [NSString stringWithUTF8String:Start.DepType()],
-                        @"target": [NSString stringWithUTF8String:Start.TargetPkg().Name()],
-                        @"comparison": [NSString stringWithUTF8String:Start.CompType()],
-                        @"requiredVersion": [NSString stringWithUTF8String:Start.TargetVer()],
-                        @"installedVersion": installedVersion
-                    };
-                    
-                    NSArray *newIssues = issues[package.identifier] ?: @[];
-                    issues[package.identifier] = [newIssues arrayByAddingObject:issue];
-                    
-                    if (Start == End) break;
-                    Start++;
+        if ((cache[End] & pkgDepCache::DepGInstall) != 0) continue; // Is this dependency actually broken?
+        
+        while (true) {
+            PLBrokenReason reason;
+            pkgCache::Version *installedTargetVersion = NULL;
+            pkgCache::PkgIterator target = Start.TargetPkg();
+            if (providesIndex && providesIndex->hasProviders(target->ID)) { // A virtual package, either the installed provider doesn't satisfy it or no provider can be found in current sources.
+                installedTargetVersion = providesIndex->installedProvider(target->ID);
+                reason = installedTargetVersion ? PLBrokenReasonAlreadyInstalled : PLBrokenReasonNotFound;
+            } else {
+                pkgCache::VerIterator installedTargetVersionIterator = cache[target].InstVerIter(cache);
+                if (!installedTargetVersionIterator.end()) { // The installed version is different than the required version (and is likely missing)
+                    reason = PLBrokenReasonAlreadyInstalled;
+                    installedTargetVersion = installedTargetVersionIterator;
+                } else { // I'm sure there are other cases but I have no idea ATM
+                    reason = PLBrokenReasonUnknown;
                 }
             }
-        }
-        
-        pkgDepCache::StateCache &state = cache[iterator];
-        if (state.NewInstall()) {
-            [packages[PLQueueInstall] addObject:package];
-        } else if (state.Upgrade()) {
-            [packages[PLQueueUpgrade] addObject:package];
-        } else if (state.Downgrade()) {
-            [packages[PLQueueDowngrade] addObject:package];
-        } else if (state.ReInstall()) {
-            [packages[PLQueueReinstall] addObject:package];
-        } else if (state.Delete()) {
-            if (!_hasEssentialPackages && package.isEssential) _hasEssentialPackages = YES;
-            [packages[PLQueueRemove] addObject:package];
+            
+            issues.push_back({Start, installedTargetVersion, reason});
+            
+            if (Start == End) break;
+            Start++;
         }
     }
     
-    _issues = issues;
-    _queuedPackages = packages;
+    return issues;
 }
 
 - (NSDictionary *)issues {
     if (_issues) return _issues;
     
     [self generatePackages];
+    pkgCache &packageCache = database.cache.GetDepCache()->GetCache();
+    NSMutableDictionary *issues = [NSMutableDictionary dictionaryWithCapacity:brokenPackages.count()];
+    brokenPackages.forEach([&](size_t packageID) {
+        pkgCache::PkgIterator iterator(packageCache, packageCache.PkgP + packageID);
+        std::vector<PLQueueIssue> packageIssues = [self issuesForPackage:iterator];
+        if (packageIssues.empty()) return;
+        
+        PLPackage *package = [database packageForIterator:iterator];
+        if (!package) return;
+        
+        NSMutableArray *bridged = [NSMutableArray arrayWithCapacity:packageIssues.size()];
+        for (PLQueueIssue const &issue : packageIssues) {
+            pkgCache::DepIterator dependency(packageCache, issue.dependency);
+            NSMutableDictionary *dictionary = [@{
+                @"reason": @(issue.reason),
+                @"relationship": [NSString stringWithUTF8String:dependency.DepType()],
+                @"target": [NSString stringWithUTF8String:dependency.TargetPkg().Name()],
+                @"comparison": [NSString stringWithUTF8String:dependency.CompType()],
+                @"requiredVersion": [NSString stringWithUTF8String:dependency.TargetVer() ?: ""],
+            } mutableCopy];
+            if (issue.installedTargetVersion) {
+                dictionary[@"installedVersion"] = [NSString stringWithUTF8String:pkgCache::VerIterator(packageCache, issue.installedTargetVersion).VerStr()];
+            }
+            [bridged addObject:dictionary];
+        }
+        issues[package.identifier] = bridged;
+    });
+    
+    _issues = issues;
     return _issues;
 }
 
@@ -138,11 +355,36 @@ NSNotificationName const PLQueueUpdateNotification = @"PLQueueUpdateNotification
     return _queuedPackages;
 }
 
+- (NSArray <PLPackage *> *)unneededPackages {
+    if (_unneededPackages) return _unneededPackages;
+    
+    [self generatePackages];
+    pkgCache &packageCache = database.cache.GetDepCache()->GetCache();
+    NSMutableArray *packages = [NSMutableArray arrayWithCapacity:garbagePackages.count()];
+    garbagePackages.forEach([&](size_t packageID) {
+        PLPackage *package = [database packageForIterator:pkgCache::PkgIterator(packageCache, packageCache.PkgP + packageID)];
+        if (package) [packages addObject:package];
+    });
+    
+    _unneededPackages = packages;
+    return _unneededPackages;
+}
+
+- (void)queueUnneededPackages {
+    [self addPackages:self.unneededPackages toQueue:PLQueueRemove];
+}
+
 - (void)resolve {
+    pkgCacheFile &cache = [database cache];
     pkgProblemResolver *resolver = [database resolver];
     
-    resolver->Resolve();
+    PLSolve(*cache.GetDepCache(), *resolver, PLQueueSolverName(), PLQueueSolverTimeout());
+    statesDirty = YES;
     
+    [self update];
+}
+
+- (void)update {
     [self generatePackages];
     
     _count = 0;
@@ -150,66 +392,199 @@ NSNotificationName const PLQueueUpdateNotification = @"PLQueueUpdateNotification
         _count += arr.count;
     }
     
-    [[NSNotificationCenter defaultCenter] postNotificationName:PLQueueUpdateNotification object:nil userInfo:@{@"count": @(_count)}];
+    NSMutableDictionary *userInfo = [self changesSinceLastUpdate];
+    userInfo[@"count"] = @(_count);
+    [[NSNotificationCenter defaultCenter] postNotificationName:PLQueueUpdateNotification object:nil userInfo:userInfo];
 }
 
-- (void)addPackage:(PLPackage *)package toQueue:(PLQueueType)queue {
-    PLPackageManager *database = [PLPackageManager sharedInstance];
-    pkgCacheFile &cache = [database cache];
-    pkgProblemResolver *resolver = [database resolver];
-    pkgCache::PkgIterator iterator = package.package;
-    
-    resolver->Clear(iterator);
-    resolver->Protect(iterator);
-    switch (queue) {
-        case PLQueueUpgrade:
-        case PLQueueInstall: {
-            cache->MarkInstall(iterator, false);
-            break;
-        }
-        case PLQueueRemove: {
-            cache->MarkDelete(iterator, true);
-            break;
+- (NSMutableDictionary *)changesSinceLastUpdate {
+    std::unordered_map<std::string, PLQueueType> queueTypes;
+    for (NSUInteger queue = 0; queue < _queuedPackages.count; queue++) {
+        for (PLPackage *package in _queuedPackages[queue]) {
+            queueTypes[package.identifier.UTF8String] = (PLQueueType)queue;
         }
-        case PLQueueReinstall: {
-            cache->SetReInstall(iterator, true);
-            break;
+    }
+    
+    NSMutableArray *added = [NSMutableArray arrayWithCapacity:PLQueueCount];
+    NSMutableArray *removed = [NSMutableArray arrayWithCapacity:PLQueueCount];
+    for (NSUInteger i = 0; i < PLQueueCount; i++) {
+        added[i] = [NSMutableArray new];
+        removed[i] = [NSMutableArray new];
+    }
+    
+    // A package that moved to a different queue is removed from the old one and added to the new one
+    for (auto const &queued : queueTypes) {
+        auto previous = postedQueueTypes.find(queued.first);
+        if (previous != postedQueueTypes.end() && previous->second == queued.second) continue;
+        
+        [added[queued.second] addObject:[NSString stringWithUTF8String:queued.first.c_str()]];
+        if (previous != postedQueueTypes.end()) {
+            [removed[previous->second] addObject:[NSString stringWithUTF8String:queued.first.c_str()]];
         }
-        case PLQueueDowngrade: {
-            cache->SetCandidateVersion(package.verIterator);
-            cache->MarkInstall(iterator, false);
-            break;
+    }
+    for (auto const &previous : postedQueueTypes) {
+        if (queueTypes.find(previous.first) == queueTypes.end()) {
+            [removed[previous.second] addObject:[NSString stringWithUTF8String:previous.first.c_str()]];
         }
-        default:
-            break;
     }
     
-    NSMutableSet *beforeIdentifiers = [NSMutableSet new];
-    for (NSArray *queue in _queuedPackages) {
-        for (PLPackage *queuedPackage in queue) {
-            [beforeIdentifiers addObject:queuedPackage];
+    postedQueueTypes.swap(queueTypes);
+    return [NSMutableDictionary dictionaryWithDictionary:@{@"added": added, @"removed": removed}];
+}
+
+- (void)addPackage:(PLPackage *)package toQueue:(PLQueueType)queue {
+    [self addPackages:@[package] toQueue:queue];
+}
+
+- (void)markPackage:(PLPackage *)package forQueue:(PLQueueType)queue {
+    pkgCacheFile &cache = [database cache];
+    pkgProblemResolver *resolver = [database resolver];
+    
+    PLQueueMarkRequest(*cache.GetDepCache(), *resolver, package.package, package.verIterator, queue);
+    statesDirty = YES;
+}
+
+- (void)addPackages:(NSArray <PLPackage *> *)packages toQueue:(PLQueueType)queue {
+    if (packages.count == 0) return;
+    
+    [self recordUndo];
+    
+    pkgCacheFile &cache = [database cache];
+    {
+        // Defer the auto-installed bookkeeping until every package has been marked
+        pkgDepCache::ActionGroup group(*cache.GetDepCache());
+        for (PLPackage *package in packages) {
+            [self markPackage:package forQueue:queue];
         }
     }
+    
+    PLBitset before = [self queuedSet];
     [self resolve];
     
-    NSMutableSet *afterIdentifiers = [NSMutableSet new];
-    for (NSArray *queue in _queuedPackages) {
-        for (PLPackage *queuedPackage in queue) {
-            [afterIdentifiers addObject:queuedPackage];
+    // Anything that is queued now but wasn't before was pulled in by this batch
+    PLBitset dependencies = [self queuedSet];
+    dependencies.subtract(before);
+    for (PLPackage *package in packages) {
+        dependencies.reset(package.package->ID);
+    }
+    
+    std::vector<std::vector<map_id_t>> attributed = [self attributeDependencies:dependencies toPackages:packages];
+    for (NSUInteger i = 0; i < packages.count; i++) {
+        enqueuedDependencies[packages[i].package->ID] = std::move(attributed[i]);
+    }
+}
+
+- (PLBitset)queuedSet {
+    PLBitset queued(packageStates.size());
+    for (size_t packageID = 0; packageID < packageStates.size(); packageID++) {
+        if ((packageStates[packageID] & ~PLQueueStateFlags) != PLQueueCount) {
+            queued.set(packageID);
         }
     }
+    return queued;
+}
+
+- (std::vector<std::vector<map_id_t>>)attributeDependencies:(PLBitset &)pending toPackages:(NSArray <PLPackage *> *)packages {
+    std::vector<std::vector<map_id_t>> attributed(packages.count);
+    if (packages.count == 1) {
+        pending.forEach([&](size_t packageID) {
+            attributed[0].push_back((map_id_t)packageID);
+        });
+        return attributed;
+    }
+    
+    pkgCacheFile &cache = [database cache];
+    pkgCache &packageCache = cache.GetDepCache()->GetCache();
+    
+    std::vector<std::pair<pkgCache::PkgIterator, size_t>> frontier;
+    for (NSUInteger i = 0; i < packages.count; i++) {
+        frontier.emplace_back(packages[i].package, i);
+    }
     
-    [afterIdentifiers minusSet:beforeIdentifiers];
-    [afterIdentifiers removeObject:package];
+    // Walk breadth first from every requested package at once so each dependency goes to the closest package that pulled it in
+    auto claim = [&](pkgCache::PkgIterator const &target, size_t owner, std::vector<std::pair<pkgCache::PkgIterator, size_t>> &next) {
+        if (!pending.test(target->ID)) return;
+        
+        attributed[owner].push_back(target->ID);
+        pending.reset(target->ID);
+        next.emplace_back(target, owner);
+    };
+    while (!frontier.empty() && pending.any()) {
+        std::vector<std::pair<pkgCache::PkgIterator, size_t>> next;
+        for (auto const &item : frontier) {
+            pkgCache::PkgIterator iterator = item.first;
+            
+            // Packages that are installed or replaced because of this one
+            pkgCache::VerIterator installVersion = cache[iterator].InstVerIter(cache);
+            if (!installVersion.end()) {
+                pkgCache::DepIterator dep = installVersion.DependsList();
+                while (!dep.end()) {
+                    // GlobOr moves dep past the whole or-group
+                    pkgCache::DepIterator start, end;
+                    dep.GlobOr(start, end);
+                    
+                    if (start.IsNegative()) {
+                        // Each conflicting version that doesn't stay is removed or replaced because of this one
+                        for (pkgCache::DepIterator alternative = start;; alternative++) {
+                            std::unique_ptr<pkgCache::Version *[]> targets(alternative.AllTargets());
+                            for (pkgCache::Version **target = targets.get(); *target != NULL; target++) {
+                                pkgCache::VerIterator version(packageCache, *target);
+                                if (cache[version.ParentPkg()].InstVerIter(cache) != version) {
+                                    claim(version.ParentPkg(), item.second, next);
+                                }
+                            }
+                            if (alternative == end) break;
+                        }
+                    } else if (start->Type == pkgCache::Dep::Depends || start->Type == pkgCache::Dep::PreDepends) {
+                        // Only the alternative the resolver actually installed is pulled in by this one
+                        bool satisfied = false;
+                        for (pkgCache::DepIterator alternative = start; !satisfied; alternative++) {
+                            std::unique_ptr<pkgCache::Version *[]> targets(alternative.AllTargets());
+                            for (pkgCache::Version **target = targets.get(); *target != NULL; target++) {
+                                pkgCache::VerIterator version(packageCache, *target);
+                                if (cache[version.ParentPkg()].InstVerIter(cache) == version) {
+                                    claim(version.ParentPkg(), item.second, next);
+                                    satisfied = true;
+                                    break;
+                                }
+                            }
+                            if (alternative == end) break;
+                        }
+                    }
+                }
+            }
+            
+            // Installed packages that are removed because they depend on this one or conflict with what replaces it
+            for (pkgCache::DepIterator dep = iterator.RevDependsList(); !dep.end(); dep++) {
+                pkgCache::PkgIterator parent = dep.ParentPkg();
+                if (parent.CurrentVer() != dep.ParentVer()) continue;
+                
+                if (dep->Type == pkgCache::Dep::Depends || dep->Type == pkgCache::Dep::PreDepends) {
+                    claim(parent, item.second, next);
+                } else if (dep.IsNegative() && !installVersion.end() && dep.IsSatisfied(installVersion)) {
+                    claim(parent, item.second, next);
+                }
+            }
+        }
+        frontier.swap(next);
+    }
     
-    enqueuedDependencies[package.identifier] = afterIdentifiers;
+    // Anything that couldn't be traced back stays with every package in the batch, like a single add would
+    pending.forEach([&](size_t packageID) {
+        for (std::vector<map_id_t> &dependencies : attributed) {
+            dependencies.push_back((map_id_t)packageID);
+        }
+    });
+    return attributed;
 }
 
 - (BOOL)canRemovePackage:(PLPackage *)package {
-    return enqueuedDependencies[package.identifier] != NULL;
+    return enqueuedDependencies.find(package.package->ID) != enqueuedDependencies.end();
 }
 
 - (void)removePackage:(PLPackage *)package {
+    [self recordUndo];
+    
     PLPackageManager *database = [PLPackageManager sharedInstance];
     pkgCacheFile &cache = [database cache];
     pkgProblemResolver *resolver = [database resolver];
@@ -219,17 +594,23 @@ NSNotificationName const PLQueueUpdateNotification = @"PLQueueUpdateNotification
     
     cache->MarkKeep(iterator, false);
     
-    for (PLPackage *dependency in enqueuedDependencies[package.identifier]) {
-        pkgCache::PkgIterator dependencyIterator = dependency.package;
-        resolver->Clear(dependencyIterator);
-        
-        cache->MarkKeep(dependencyIterator, false);
+    auto dependencies = enqueuedDependencies.find(iterator->ID);
+    if (dependencies != enqueuedDependencies.end()) {
+        pkgCache &packageCache = cache.GetDepCache()->GetCache();
+        for (map_id_t dependencyID : dependencies->second) {
+            pkgCache::PkgIterator dependencyIterator(packageCache, packageCache.PkgP + dependencyID);
+            resolver->Clear(dependencyIterator);
+            
+            cache->MarkKeep(dependencyIterator, false);
+        }
     }
     
     [self resolve];
 }
 
 - (void)clear {
+    [self recordUndo];
+    
     PLPackageManager *database = [PLPackageManager sharedInstance];
     pkgCacheFile &cache = [database cache];
     pkgProblemResolver *resolver = [database resolver];
@@ -246,6 +627,356 @@ NSNotificationName const PLQueueUpdateNotification = @"PLQueueUpdateNotification
     [self resolve];
 }
 
+#pragma mark - Undo
+
+- (PLQueueSnapshot)snapshot {
+    // Bring the cached states up to date so that the snapshot matches the depcache
+    [self generatePackages];
+    
+    pkgDepCache *depCache = [database cache].GetDepCache();
+    
+    PLQueueSnapshot snapshot;
+    snapshot.generation = stateGeneration;
+    snapshot.dependencies = enqueuedDependencies;
+    snapshot.marks = PLQueueCaptureMarks(*depCache, [self queuedSet]);
+    return snapshot;
+}
+
+- (void)recordUndo {
+    undoStack.push_back([self snapshot]);
+    if (undoStack.size() > PLQueueUndoLimit) {
+        undoStack.erase(undoStack.begin());
+    }
+    redoStack.clear();
+}
+
+- (void)restoreSnapshot:(PLQueueSnapshot const &)snapshot {
+    pkgDepCache *depCache = [database cache].GetDepCache();
+    pkgCache &packageCache = depCache->GetCache();
+    
+    PLBitset marked(packageStates.size());
+    for (PLQueueMark const &mark : snapshot.marks) {
+        marked.set(mark.packageID);
+    }
+    
+    {
+        pkgDepCache::ActionGroup group(*depCache);
+        
+        // Packages that weren't queued at the time go back to being kept with their policy candidate
+        PLBitset unmarked = [self queuedSet];
+        unmarked.subtract(marked);
+        unmarked.forEach([&](size_t packageID) {
+            pkgCache::PkgIterator iterator(packageCache, packageCache.PkgP + packageID);
+            depCache->MarkKeep(iterator, false, false);
+            depCache->SetReInstall(iterator, false);
+            
+            pkgCache::VerIterator candidate = [database candidateForPackageIterator:iterator];
+            if (!candidate.end() && (*depCache)[iterator].CandidateVer != candidate) {
+                depCache->SetCandidateVersion(candidate);
+            }
+        });
+        
+        PLQueueApplyMarks(*depCache, snapshot.marks);
+    }
+    statesDirty = YES;
+    
+    enqueuedDependencies = snapshot.dependencies;
+    [self update];
+}
+
+- (void)dropStaleSnapshots {
+    // Marks and package IDs from another cache generation would be applied to unrelated packages
+    NSUInteger generation = database.cacheGeneration;
+    auto isStale = [generation](PLQueueSnapshot const &snapshot) {
+        return snapshot.generation != generation;
+    };
+    undoStack.erase(std::remove_if(undoStack.begin(), undoStack.end(), isStale), undoStack.end());
+    redoStack.erase(std::remove_if(redoStack.begin(), redoStack.end(), isStale), redoStack.end());
+}
+
+- (BOOL)canUndo {
+    [self dropStaleSnapshots];
+    return !undoStack.empty();
+}
+
+- (BOOL)canRedo {
+    [self dropStaleSnapshots];
+    return !redoStack.empty();
+}
+
+- (void)undo {
+    [self dropStaleSnapshots];
+    if (undoStack.empty()) return;
+    
+    PLQueueSnapshot snapshot = std::move(undoStack.back());
+    undoStack.pop_back();
+    redoStack.push_back([self snapshot]);
+    [self restoreSnapshot:snapshot];
+}
+
+- (void)redo {
+    [self dropStaleSnapshots];
+    if (redoStack.empty()) return;
+    
+    PLQueueSnapshot snapshot = std::move(redoStack.back());
+    redoStack.pop_back();
+    undoStack.push_back([self snapshot]);
+    [self restoreSnapshot:snapshot];
+}
+
+#pragma mark - Conflicts
+
+- (NSArray <NSDictionary *> *)conflictsForPackage:(PLPackage *)package {
+    pkgDepCache *depCache = [database cache].GetDepCache();
+    pkgCache &packageCache = depCache->GetCache();
+    pkgCache::VerIterator version = package.verIterator;
+    if (version.Cache() != &packageCache) return @[];
+    
+    pkgCache::PkgIterator parent = version.ParentPkg();
+    NSMutableArray *conflicts = [NSMutableArray new];
+    auto report = [&](pkgCache::DepIterator const &dep, PLBrokenReason reason, pkgCache::PkgIterator const &other) {
+        NSMutableDictionary *conflict = [@{
+            @"reason": @(reason),
+            @"relationship": [NSString stringWithUTF8String:dep.DepType()],
+            @"target": [NSString stringWithUTF8String:dep.TargetPkg().Name()],
+            @"comparison": [NSString stringWithUTF8String:dep.CompType()],
+            @"requiredVersion": [NSString stringWithUTF8String:dep.TargetVer() ?: ""],
+        } mutableCopy];
+        if (!other.end()) conflict[@"package"] = [NSString stringWithUTF8String:other.Name()];
+        [conflicts addObject:conflict];
+    };
+    
+    // The version each package is left with once the queue is applied, the installed version for anything that isn't queued
+    auto present = [&](pkgCache::VerIterator const &target) {
+        return (*depCache)[target.ParentPkg()].InstVerIter(*depCache) == target;
+    };
+    auto isConflict = [](pkgCache::DepIterator const &dep) {
+        return dep->Type == pkgCache::Dep::Conflicts || dep->Type == pkgCache::Dep::DpkgBreaks;
+    };
+    
+    // What this version conflicts with and depends on
+    pkgCache::DepIterator dep = version.DependsList();
+    while (!dep.end()) {
+        pkgCache::DepIterator start;
+        pkgCache::DepIterator end;
+        dep.GlobOr(start, end);
+        
+        if (isConflict(start)) {
+            std::unique_ptr<pkgCache::Version *[]> targets(start.AllTargets());
+            for (pkgCache::Version **target = targets.get(); *target != NULL; target++) {
+                pkgCache::VerIterator targetVersion(packageCache, *target);
+                if (targetVersion.ParentPkg() != parent && present(targetVersion)) {
+                    report(start, PLBrokenReasonConflict, targetVersion.ParentPkg());
+                }
+            }
+        } else if (start->Type == pkgCache::Dep::Depends || start->Type == pkgCache::Dep::PreDepends) {
+            bool satisfiable = false;
+            for (pkgCache::DepIterator alternative = start; !satisfiable; alternative++) {
+                std::unique_ptr<pkgCache::Version *[]> targets(alternative.AllTargets());
+                for (pkgCache::Version **target = targets.get(); *target != NULL && !satisfiable; target++) {
+                    pkgCache::VerIterator targetVersion(packageCache, *target);
+                    satisfiable = present(targetVersion) || [database candidateForPackageIterator:targetVersion.ParentPkg()] == targetVersion;
+                }
+                if (alternative == end) break;
+            }
+            if (!satisfiable) report(start, PLBrokenReasonNotFound, pkgCache::PkgIterator());
+        }
+    }
+    
+    // Installed packages that conflict with this version or something it provides, unless the queue is replacing or removing them
+    auto checkOwner = [&](pkgCache::DepIterator const &conflict) {
+        pkgCache::PkgIterator owner = conflict.ParentPkg();
+        if (owner == parent || !present(conflict.ParentVer())) return;
+        
+        if (conflict.TargetPkg() == parent) {
+            if (conflict.IsSatisfied(version)) report(conflict, PLBrokenReasonConflict, owner);
+            return;
+        }
+        for (pkgCache::PrvIterator provides = version.ProvidesList(); !provides.end(); provides++) {
+            if (provides.ParentPkg() == conflict.TargetPkg() && conflict.IsSatisfied(provides)) {
+                report(conflict, PLBrokenReasonConflict, owner);
+                return;
+            }
+        }
+    };
+    std::shared_ptr<PLReverseDependencyIndex> index = [database reverseDependencyIndex];
+    if (index) {
+        for (pkgCache::Dependency *conflict : index->conflicts(parent->ID)) {
+            checkOwner(pkgCache::DepIterator(packageCache, conflict));
+        }
+        for (pkgCache::PrvIterator provides = version.ProvidesList(); !provides.end(); provides++) {
+            for (pkgCache::Dependency *conflict : index->conflicts(provides.ParentPkg()->ID)) {
+                checkOwner(pkgCache::DepIterator(packageCache, conflict));
+            }
+        }
+    }
+    
+    // Queued versions that aren't installed yet aren't in the index, but there are only ever a few of them
+    if (stateCache == &packageCache) {
+        for (PLQueueType queue : {PLQueueInstall, PLQueueUpgrade, PLQueueDowngrade}) {
+            for (map_id_t packageID : queueMembers[queue]) {
+                pkgCache::PkgIterator queued(packageCache, packageCache.PkgP + packageID);
+                pkgCache::VerIterator queuedVersion = (*depCache)[queued].InstVerIter(*depCache);
+                if (queuedVersion.end()) continue;
+                
+                for (pkgCache::DepIterator conflict = queuedVersion.DependsList(); !conflict.end(); conflict++) {
+                    if (isConflict(conflict)) checkOwner(conflict);
+                }
+            }
+        }
+    }
+    
+    return conflicts;
+}
+
+#pragma mark - Planning
+
+- (void)planInstalling:(NSArray <PLPackage *> *)install removing:(NSArray <PLPackage *> *)remove completion:(void (^)(PLTransactionPlan * _Nullable plan))completion {
+    // Bring the cached states up to date so that the plan starts from the current queue
+    [self generatePackages];
+    
+    pkgDepCache *sharedDepCache = [database cache].GetDepCache();
+    pkgCache *packageCache = &sharedDepCache->GetCache();
+    NSUInteger generation = database.policyGeneration;
+    std::vector<pkgCache::Version *> candidates = [database candidateVersions];
+    std::vector<PLQueueMark> marks = PLQueueCaptureMarks(*sharedDepCache, [self queuedSet]);
+    std::string solver = PLQueueSolverName();
+    double timeout = PLQueueSolverTimeout();
+    
+    std::vector<std::pair<map_id_t, pkgCache::Version *>> installs;
+    for (PLPackage *package in install) {
+        installs.emplace_back(package.package->ID, (pkgCache::Version *)package.verIterator);
+    }
+    std::vector<map_id_t> removals;
+    for (PLPackage *package in remove) {
+        removals.push_back(package.package->ID);
+    }
+    
+    PLPackageManager *database = self->database;
+    dispatch_async([database cacheReaderQueue], ^{
+        // apt has no copy-on-write depcache, but the pkgCache underneath is a read-only mapping, so each plan gets its own depcache on top of it
+        PLCandidatePolicy policy(*packageCache, candidates);
+        pkgDepCache depCache(packageCache, &policy);
+        if (!depCache.Init(NULL)) {
+            _error->Discard();
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(nil);
+            });
+            return;
+        }
+        
+        pkgProblemResolver resolver(&depCache);
+        {
+            pkgDepCache::ActionGroup group(depCache);
+            PLQueueApplyMarks(depCache, marks);
+            
+            for (auto const &item : installs) {
+                pkgCache::PkgIterator iterator(*packageCache, packageCache->PkgP + item.first);
+                PLQueueType queue = item.second && depCache[iterator].CandidateVer != item.second ? PLQueueDowngrade : PLQueueInstall;
+                PLQueueMarkRequest(depCache, resolver, iterator, pkgCache::VerIterator(*packageCache, item.second), queue);
+            }
+            for (map_id_t packageID : removals) {
+                pkgCache::PkgIterator iterator(*packageCache, packageCache->PkgP + packageID);
+                PLQueueMarkRequest(depCache, resolver, iterator, pkgCache::VerIterator(*packageCache), PLQueueRemove);
+            }
+        }
+        
+        BOOL resolved = PLSolve(depCache, resolver, solver, timeout).resolved;
+        _error->Discard();
+        
+        auto queued = std::make_shared<std::vector<std::vector<map_id_t>>>(PLQueueCount);
+        for (pkgCache::PkgIterator iterator = depCache.PkgBegin(); !iterator.end(); iterator++) {
+            uint8_t queue = PLQueueStateForPackage(depCache[iterator]) & ~PLQueueStateFlags;
+            if (queue < PLQueueCount) (*queued)[queue].push_back(iterator->ID);
+        }
+        unsigned long long downloadSize = depCache.DebSize();
+        long long installedSizeChange = depCache.UsrSize();
+        NSUInteger brokenCount = depCache.BrokenCount();
+        
+        // Package objects belong to the main thread and only exist for the generation the plan was made from
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (&[database cache].GetDepCache()->GetCache() != packageCache || database.policyGeneration != generation) {
+                completion(nil);
+                return;
+            }
+            
+            NSMutableArray *packages = [NSMutableArray arrayWithCapacity:PLQueueCount];
+            for (NSUInteger i = 0; i < PLQueueCount; i++) {
+                NSMutableArray *packagesInQueue = [NSMutableArray arrayWithCapacity:(*queued)[i].size()];
+                for (map_id_t packageID : (*queued)[i]) {
+                    PLPackage *package = [database packageForIterator:pkgCache::PkgIterator(*packageCache, packageCache->PkgP + packageID)];
+                    if (package) [packagesInQueue addObject:package];
+                }
+                packages[i] = packagesInQueue;
+            }
+            completion([[PLTransactionPlan alloc] initWithQueuedPackages:packages downloadSize:downloadSize installedSizeChange:installedSizeChange resolved:resolved brokenCount:brokenCount]);
+        });
+    });
+}
+
+#pragma mark - Solvers
+
+- (NSDictionary <NSString *, NSNumber *> *)scenario {
+    [self generatePackages];
+    
+    pkgCache &packageCache = [database cache].GetDepCache()->GetCache();
+    NSMutableDictionary *scenario = [NSMutableDictionary dictionaryWithCapacity:enqueuedDependencies.size()];
+    for (auto const &item : enqueuedDependencies) {
+        uint8_t queue = packageStates[item.first] & ~PLQueueStateFlags;
+        PLPackage *package = [database packageForIterator:pkgCache::PkgIterator(packageCache, packageCache.PkgP + item.first)];
+        if (package && queue < PLQueueCount) scenario[package.identifier] = @(queue);
+    }
+    return scenario;
+}
+
+- (NSArray <NSDictionary <NSString *, id> *> *)benchmarkSolvers:(NSArray <NSString *> *)solvers withScenarios:(NSArray <NSDictionary <NSString *, NSNumber *> *> *)scenarios timeout:(NSTimeInterval)timeout {
+    pkgCache *packageCache = &[database cache].GetDepCache()->GetCache();
+    std::vector<pkgCache::Version *> candidates = [database candidateVersions];
+    
+    NSMutableArray *results = [NSMutableArray arrayWithCapacity:solvers.count * scenarios.count];
+    for (NSUInteger i = 0; i < scenarios.count; i++) {
+        std::vector<std::pair<PLPackage *, PLQueueType>> requests;
+        for (NSString *identifier in scenarios[i]) {
+            PLPackage *package = [database packageWithIdentifier:identifier];
+            if (package) requests.emplace_back(package, (PLQueueType)scenarios[i][identifier].unsignedIntegerValue);
+        }
+        
+        for (NSString *solver in solvers) {
+            // Every run starts from a fresh depcache with nothing queued so that solvers are compared on the same problem
+            PLCandidatePolicy policy(*packageCache, candidates);
+            pkgDepCache depCache(packageCache, &policy);
+            if (!depCache.Init(NULL)) break;
+            
+            pkgProblemResolver resolver(&depCache);
+            {
+                pkgDepCache::ActionGroup group(depCache);
+                for (auto const &request : requests) {
+                    PLQueueMarkRequest(depCache, resolver, request.first.package, request.first.verIterator, request.second);
+                }
+            }
+            
+            PLSolverResult result = PLSolve(depCache, resolver, solver.UTF8String, timeout);
+            _error->Discard();
+            
+            NSUInteger size = 0;
+            for (pkgCache::PkgIterator iterator = depCache.PkgBegin(); !iterator.end(); iterator++) {
+                if ((PLQueueStateForPackage(depCache[iterator]) & ~PLQueueStateFlags) != PLQueueCount) size++;
+            }
+            
+            [results addObject:@{
+                @"scenario": @(i),
+                @"solver": solver,
+                @"time": @(result.seconds),
+                @"size": @(size),
+                @"resolved": @(result.resolved),
+                @"external": @(result.external),
+                @"timedOut": @(result.timedOut),
+            }];
+        }
+    }
+    return results;
+}
+
 - (void)queueLocalPackage:(NSURL *)url {
     PLPackage *local = [[PLPackageManager sharedInstance] addDebFile:url error:nil];
     if (local) {
@@ -0,0 +1,73 @@
+//
+//  PLQueueMarks.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLQueueMarks_h
+#define PLQueueMarks_h
+
+#import <Plains/PLConstants.h>
+#import "PLQueue.h"
+#import "PLBitset.h"
+
+PL_APT_PKG_IMPORTS_BEGIN
+#include <apt-pkg/algorithms.h>
+#include <apt-pkg/depcache.h>
+PL_APT_PKG_IMPORTS_END
+
+#include <vector>
+
+/*!
+ Set on a queue state when the package's dependencies are broken.
+ */
+static const uint8_t PLQueueStateBroken = 0x80;
+
+/*!
+ Set on a queue state when the package is installed, isn't queued and the last mark and sweep found nothing that still needs it.
+ */
+static const uint8_t PLQueueStateUnneeded = 0x40;
+
+/*!
+ Every flag that can be combined with the queue in a state, mask them out to get the queue.
+ */
+static const uint8_t PLQueueStateFlags = PLQueueStateBroken | PLQueueStateUnneeded;
+
+/*!
+ The queue a package is in, or `PLQueueCount` if it isn't queued, combined with `PLQueueStateBroken` and `PLQueueStateUnneeded`.
+ */
+uint8_t PLQueueStateForPackage(pkgDepCache::StateCache &state);
+
+/*!
+ The mark state of a single queued package.
+ */
+struct PLQueueMark {
+    map_id_t packageID;
+    pkgCache::Version *candidate;
+    uint8_t mode;
+    bool reinstall;
+    bool purge;
+    bool automatic;
+};
+
+/*!
+ Record the marks of `packages` in `depCache`.
+ */
+std::vector<PLQueueMark> PLQueueCaptureMarks(pkgDepCache &depCache, PLBitset const &packages);
+
+/*!
+ Apply previously captured marks to `depCache` without following dependencies or running the resolver. Packages whose marks already match are left alone.
+
+ Should be called inside a `pkgDepCache::ActionGroup`.
+ */
+void PLQueueApplyMarks(pkgDepCache &depCache, std::vector<PLQueueMark> const &marks);
+
+/*!
+ Mark a package for a queue the way the user asked for it, protecting it from the resolver.
+
+ - parameter version: The version to install. Only used for downgrades, every other queue installs the candidate.
+ */
+void PLQueueMarkRequest(pkgDepCache &depCache, pkgProblemResolver &resolver, pkgCache::PkgIterator const &iterator, pkgCache::VerIterator const &version, PLQueueType queue);
+
+#endif /* PLQueueMarks_h */
@@ -0,0 +1,105 @@
+//
+//  PLQueueMarks.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLQueueMarks.h"
+
+uint8_t PLQueueStateForPackage(pkgDepCache::StateCache &state) {
+    uint8_t queue = PLQueueCount;
+    if (state.NewInstall()) {
+        queue = PLQueueInstall;
+    } else if (state.Upgrade()) {
+        queue = PLQueueUpgrade;
+    } else if (state.Downgrade()) {
+        queue = PLQueueDowngrade;
+    } else if (state.ReInstall()) {
+        queue = PLQueueReinstall;
+    } else if (state.Delete()) {
+        queue = PLQueueRemove;
+    }
+    
+    // Garbage is also set on auto-installed packages that are about to be installed, those are already in the queue
+    uint8_t flags = state.InstBroken() ? PLQueueStateBroken : 0;
+    if (queue == PLQueueCount && state.Garbage) flags |= PLQueueStateUnneeded;
+    return queue | flags;
+}
+
+std::vector<PLQueueMark> PLQueueCaptureMarks(pkgDepCache &depCache, PLBitset const &packages) {
+    pkgCache &packageCache = depCache.GetCache();
+
+    std::vector<PLQueueMark> marks;
+    packages.forEach([&](size_t packageID) {
+        pkgCache::PkgIterator iterator(packageCache, packageCache.PkgP + packageID);
+        pkgDepCache::StateCache &state = depCache[iterator];
+        marks.push_back({
+            (map_id_t)packageID,
+            state.CandidateVer,
+            (uint8_t)state.Mode,
+            (state.iFlags & pkgDepCache::ReInstall) != 0,
+            (state.iFlags & pkgDepCache::Purge) != 0,
+            (state.Flags & pkgCache::Flag::Auto) != 0,
+        });
+    });
+    return marks;
+}
+
+void PLQueueApplyMarks(pkgDepCache &depCache, std::vector<PLQueueMark> const &marks) {
+    pkgCache &packageCache = depCache.GetCache();
+
+    // The marks already contain every package the resolver touched, so dependencies are not followed
+    for (PLQueueMark const &mark : marks) {
+        pkgCache::PkgIterator iterator(packageCache, packageCache.PkgP + mark.packageID);
+        pkgDepCache::StateCache &state = depCache[iterator];
+        bool reinstall = (state.iFlags & pkgDepCache::ReInstall) != 0;
+        bool purge = (state.iFlags & pkgDepCache::Purge) != 0;
+        bool automatic = (state.Flags & pkgCache::Flag::Auto) != 0;
+        if (state.CandidateVer == mark.candidate && (uint8_t)state.Mode == mark.mode && reinstall == mark.reinstall && purge == mark.purge && automatic == mark.automatic) continue;
+
+        if (mark.candidate && state.CandidateVer != mark.candidate) {
+            depCache.SetCandidateVersion(pkgCache::VerIterator(packageCache, mark.candidate));
+        }
+        switch (mark.mode) {
+            case pkgDepCache::ModeInstall:
+                depCache.MarkInstall(iterator, false, 0, false);
+                break;
+            case pkgDepCache::ModeDelete:
+                depCache.MarkDelete(iterator, mark.purge, 0, false);
+                break;
+            default:
+                depCache.MarkKeep(iterator, false, false);
+                break;
+        }
+        depCache.SetReInstall(iterator, mark.reinstall);
+        depCache.MarkAuto(iterator, mark.automatic);
+    }
+}
+
+void PLQueueMarkRequest(pkgDepCache &depCache, pkgProblemResolver &resolver, pkgCache::PkgIterator const &iterator, pkgCache::VerIterator const &version, PLQueueType queue) {
+    resolver.Clear(iterator);
+    resolver.Protect(iterator);
+    switch (queue) {
+        case PLQueueUpgrade:
+        case PLQueueInstall: {
+            depCache.MarkInstall(iterator, false);
+            break;
+        }
+        case PLQueueRemove: {
+            depCache.MarkDelete(iterator, true);
+            break;
+        }
+        case PLQueueReinstall: {
+            depCache.SetReInstall(iterator, true);
+            break;
+        }
+        case PLQueueDowngrade: {
+            depCache.SetCandidateVersion(version);
+            depCache.MarkInstall(iterator, false);
+            break;
+        }
+        default:
+            break;
+    }
+}
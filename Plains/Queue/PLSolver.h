@@ -0,0 +1,51 @@
+//
+//  PLSolver.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLSolver_h
+#define PLSolver_h
+
+#import <Plains/PLConstants.h>
+
+PL_APT_PKG_IMPORTS_BEGIN
+#include <apt-pkg/algorithms.h>
+#include <apt-pkg/depcache.h>
+PL_APT_PKG_IMPORTS_END
+
+#include <string>
+
+/*!
+ The name of the solver that is built into libapt.
+ */
+extern const char *const PLSolverInternal;
+
+/*!
+ How a call to `PLSolve` went.
+ */
+struct PLSolverResult {
+    /*! Whether or not every dependency is satisfied. */
+    bool resolved;
+    /*! Whether the external solver's solution was used. `false` when the internal resolver ran, either because it was asked for or as a fallback. */
+    bool external;
+    /*! Whether the external solver ran out of time before answering. */
+    bool timedOut;
+    /*! Wall-clock time spent solving, including any fallback. */
+    double seconds;
+};
+
+/*!
+ Resolve the broken dependencies in `depCache`.
+
+ If `solver` names an EDSP solver other than `internal` it is run first with a wall-clock budget. The solution is only applied once the solver has exited successfully, so a solver that fails, runs out of time or leaves packages broken has no effect and `resolver` is used instead.
+
+ - parameter depCache: The depcache to resolve.
+ - parameter resolver: The internal resolver of `depCache`, with the requested packages already protected.
+ - parameter solver: The name of a solver in `Dir::Bin::Solvers`, or `internal`.
+ - parameter timeout: The number of seconds the external solver is given, including the time to send it the scenario.
+ */
+PLSolverResult PLSolve(pkgDepCache &depCache, pkgProblemResolver &resolver, std::string const &solver, double timeout);
+
+#endif /* PLSolver_h */
@@ -0,0 +1,191 @@
+//
+//  PLSolver.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLSolver.h"
+
+#import <Foundation/Foundation.h>
+
+#import "PLBitset.h"
+#import "PLQueueMarks.h"
+
+PL_APT_PKG_IMPORTS_BEGIN
+#include <apt-pkg/edsp.h>
+#include <apt-pkg/error.h>
+#include <apt-pkg/fileutl.h>
+PL_APT_PKG_IMPORTS_END
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+const char *const PLSolverInternal = "internal";
+
+enum class PLExternalSolverStatus {
+    Solved,
+    Failed,
+    TimedOut,
+};
+
+static void PLCloseDescriptor(int &descriptor) {
+    if (descriptor < 0) return;
+
+    close(descriptor);
+    descriptor = -1;
+}
+
+/*!
+ Send the scenario to the solver and collect its whole response before the deadline.
+
+ Both pipes are non-blocking and serviced from a single poll loop, so a solver that stops reading or never answers can't hold us past the deadline.
+ */
+static PLExternalSolverStatus PLExchangeWithSolver(pid_t solverPID, int input, int output, int request, std::chrono::steady_clock::time_point deadline, std::string &response) {
+    fcntl(input, F_SETFL, fcntl(input, F_GETFL) | O_NONBLOCK);
+    fcntl(output, F_SETFL, fcntl(output, F_GETFL) | O_NONBLOCK);
+#ifdef F_SETNOSIGPIPE
+    // A solver that exits early must not take the app down with it
+    fcntl(input, F_SETNOSIGPIPE, 1);
+#endif
+
+    std::vector<char> buffer(64 * 1024);
+    size_t pending = 0;
+    size_t offset = 0;
+    PLExternalSolverStatus status = PLExternalSolverStatus::Solved;
+    while (output >= 0) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            status = PLExternalSolverStatus::TimedOut;
+            break;
+        }
+
+        struct pollfd descriptors[2] = {{output, POLLIN, 0}, {input, POLLOUT, 0}};
+        int ready = poll(descriptors, input >= 0 ? 2 : 1, (int)remaining.count() + 1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            status = PLExternalSolverStatus::Failed;
+            break;
+        }
+
+        if (input >= 0 && descriptors[1].revents) {
+            if (offset == pending) {
+                ssize_t length = read(request, buffer.data(), buffer.size());
+                pending = length > 0 ? length : 0;
+                offset = 0;
+                if (length <= 0) PLCloseDescriptor(input); // The solver starts once it sees the end of the scenario
+            }
+            if (input >= 0) {
+                ssize_t written = write(input, buffer.data() + offset, pending - offset);
+                if (written >= 0) {
+                    offset += written;
+                } else if (errno != EAGAIN && errno != EINTR) {
+                    // The solver stopped reading, it may still explain why on its output
+                    PLCloseDescriptor(input);
+                }
+            }
+        }
+
+        if (descriptors[0].revents) {
+            char chunk[16 * 1024];
+            ssize_t length = read(output, chunk, sizeof(chunk));
+            if (length > 0) {
+                response.append(chunk, length);
+            } else if (length == 0) {
+                PLCloseDescriptor(output);
+            } else if (errno != EAGAIN && errno != EINTR) {
+                status = PLExternalSolverStatus::Failed;
+                break;
+            }
+        }
+    }
+    PLCloseDescriptor(input);
+    PLCloseDescriptor(output);
+
+    if (status != PLExternalSolverStatus::Solved) {
+        kill(solverPID, SIGKILL);
+    }
+
+    int exitStatus = 0;
+    while (waitpid(solverPID, &exitStatus, 0) < 0 && errno == EINTR);
+    if (status == PLExternalSolverStatus::Solved && (!WIFEXITED(exitStatus) || WEXITSTATUS(exitStatus) != 0)) {
+        status = PLExternalSolverStatus::Failed;
+    }
+    return status;
+}
+
+static PLExternalSolverStatus PLRunExternalSolver(pkgDepCache &depCache, std::string const &solver, double timeout) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeout));
+
+    // The scenario is written out before the solver starts so that writing it can't block on the solver
+    std::unique_ptr<FileFd> request(GetTempFile("plains-edsp-request"));
+    if (!request || !EDSP::WriteRequest(depCache, *request, 0, NULL) || !EDSP::WriteScenario(depCache, *request, NULL) || !request->Flush()) {
+        return PLExternalSolverStatus::Failed;
+    }
+    lseek(request->Fd(), 0, SEEK_SET);
+
+    int input = -1;
+    int output = -1;
+    pid_t solverPID = EDSP::ExecuteSolver(solver.c_str(), &input, &output, true);
+    if (solverPID <= 0) return PLExternalSolverStatus::Failed;
+
+    std::string response;
+    PLExternalSolverStatus status = PLExchangeWithSolver(solverPID, input, output, request->Fd(), deadline, response);
+    if (status != PLExternalSolverStatus::Solved) return status;
+
+    std::unique_ptr<FileFd> responseFile(GetTempFile("plains-edsp-response"));
+    if (!responseFile || !responseFile->Write(response.data(), response.size()) || !responseFile->Flush()) {
+        return PLExternalSolverStatus::Failed;
+    }
+    lseek(responseFile->Fd(), 0, SEEK_SET);
+
+    // Keep the marks from before the response so that a solution that doesn't hold up can be taken back
+    PLBitset packages(depCache.Head().PackageCount);
+    packages.fill();
+    std::vector<PLQueueMark> marks = PLQueueCaptureMarks(depCache, packages);
+
+    bool applied;
+    {
+        pkgDepCache::ActionGroup group(depCache);
+        applied = EDSP::ReadResponse(responseFile->Fd(), depCache, NULL) && depCache.BrokenCount() == 0;
+        if (!applied) PLQueueApplyMarks(depCache, marks);
+    }
+    return applied ? PLExternalSolverStatus::Solved : PLExternalSolverStatus::Failed;
+}
+
+PLSolverResult PLSolve(pkgDepCache &depCache, pkgProblemResolver &resolver, std::string const &solver, double timeout) {
+    auto start = std::chrono::steady_clock::now();
+    PLSolverResult result = {false, false, false, 0};
+
+    if (!solver.empty() && solver != PLSolverInternal) {
+        PLExternalSolverStatus status = PLRunExternalSolver(depCache, solver, timeout);
+        if (status == PLExternalSolverStatus::Solved) {
+            result.resolved = true;
+            result.external = true;
+        } else {
+            result.timedOut = status == PLExternalSolverStatus::TimedOut;
+
+            std::string error;
+            while (!_error->empty()) {
+                bool warning = !_error->PopMessage(error);
+                NSLog(@"[Plains] %@ from solver %s: %s", warning ? @"Warning" : @"Error", solver.c_str(), error.c_str());
+            }
+            NSLog(@"[Plains] Solver %s %s, falling back to the internal resolver", solver.c_str(), result.timedOut ? "timed out" : "failed");
+        }
+    }
+
+    if (!result.external) {
+        result.resolved = resolver.Resolve();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,60 @@
+//
+//  PLTransactionPlan.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import <Foundation/Foundation.h>
+
+@class PLPackage;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*!
+ The outcome of a what-if transaction computed by `-[PLQueue planInstalling:removing:completion:]`.
+
+ A plan is computed on a private copy of the dependency state, so building one never changes the queue.
+ */
+NS_SWIFT_NAME(TransactionPlan)
+@interface PLTransactionPlan : NSObject
+
+/*!
+ An array of arrays containing the packages that would be queued if the transaction were applied, including packages that are already queued.
+
+ Each index can be represented by a PLQueueType.
+ */
+@property (nonatomic, readonly) NSArray <NSArray <PLPackage *> *> *queuedPackages;
+
+/*!
+ The total number of packages that would be queued.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/*!
+ The number of bytes that would have to be downloaded.
+ */
+@property (nonatomic, readonly) unsigned long long downloadSize;
+
+/*!
+ The change in disk usage in bytes once the transaction is complete. Negative if space would be freed.
+ */
+@property (nonatomic, readonly) long long installedSizeChange;
+
+/*!
+ Whether or not the resolver was able to satisfy every dependency.
+ */
+@property (nonatomic, readonly, getter=isResolved) BOOL resolved;
+
+/*!
+ The number of packages that would be left with broken dependencies.
+ */
+@property (nonatomic, readonly) NSUInteger brokenCount;
+
+- (instancetype)initWithQueuedPackages:(NSArray <NSArray <PLPackage *> *> *)queuedPackages downloadSize:(unsigned long long)downloadSize installedSizeChange:(long long)installedSizeChange resolved:(BOOL)resolved brokenCount:(NSUInteger)brokenCount NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,29 @@
+//
+//  PLTransactionPlan.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLTransactionPlan.h"
+
+@implementation PLTransactionPlan
+
+- (instancetype)initWithQueuedPackages:(NSArray <NSArray <PLPackage *> *> *)queuedPackages downloadSize:(unsigned long long)downloadSize installedSizeChange:(long long)installedSizeChange resolved:(BOOL)resolved brokenCount:(NSUInteger)brokenCount {
+    self = [super init];
+
+    if (self) {
+        _queuedPackages = queuedPackages;
+        _downloadSize = downloadSize;
+        _installedSizeChange = installedSizeChange;
+        _resolved = resolved;
+        _brokenCount = brokenCount;
+        for (NSArray *queue in queuedPackages) {
+            _count += queue.count;
+        }
+    }
+
+    return self;
+}
+
+@end
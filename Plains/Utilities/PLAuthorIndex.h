@@ -0,0 +1,74 @@
+//
+//  PLAuthorIndex.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLAuthorIndex_h
+#define PLAuthorIndex_h
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ Distinct people listed in an RFC822 formatted control field, such as `Author` or `Maintainer`, for every package in a cache generation.
+
+ Each distinct name and email pair is parsed once and keeps a sorted posting list of the packages that spell it that way, so author search only has to look at distinct names and a package's author is the one its own field names. Pairs that share an email are grouped for "more by this developer". Package IDs are `pkgCache::Package::ID` values.
+ */
+class PLAuthorIndex {
+public:
+    struct Author {
+        std::string name;
+        std::string email;
+        std::string foldedName;
+        std::vector<uint32_t> packageIDs;
+    };
+
+    explicit PLAuthorIndex(size_t packageCount);
+
+    /*!
+     Fold a string for case and diacritic insensitive comparison, the same way `CONTAINS[cd]` does.
+     */
+    static std::string fold(std::string const &value);
+
+    /*!
+     Parse and add the RFC822 value of a package's field.
+     */
+    void addPackage(uint32_t packageID, std::string const &rfc822Value);
+
+    /*!
+     Remove a package from the posting list of the person it names. Names are kept even if no package uses them anymore.
+     */
+    void removePackage(uint32_t packageID);
+
+    /*!
+     The person named by a package, or `nullptr` if the package doesn't have the field.
+     */
+    const Author *author(uint32_t packageID) const {
+        if (packageID >= _packageAuthors.size() || _packageAuthors[packageID] == UINT32_MAX) return nullptr;
+        return &_authors[_packageAuthors[packageID]];
+    }
+
+    /*!
+     The packages of a person, in ascending package ID order. People with an email address are matched by email alone, whatever name each package uses, otherwise by folded name among the entries without an email.
+     */
+    std::vector<uint32_t> packages(std::string const &name, std::string const &email) const;
+
+    /*!
+     The packages of every person whose folded name contains `foldedQuery`, in ascending package ID order.
+     */
+    std::vector<uint32_t> search(std::string const &foldedQuery) const;
+
+private:
+    static std::string personKey(std::string const &foldedName, std::string const &email);
+
+    // Exact spellings, and the spellings grouped into the same person
+    std::unordered_map<std::string, uint32_t> _authorIDs;
+    std::unordered_map<std::string, std::vector<uint32_t>> _personAuthorIDs;
+    std::vector<Author> _authors;
+    std::vector<uint32_t> _packageAuthors;
+};
+
+#endif /* PLAuthorIndex_h */
@@ -0,0 +1,107 @@
+//
+//  PLAuthorIndex.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLAuthorIndex.h"
+
+#import <Foundation/Foundation.h>
+
+#include <algorithm>
+
+PLAuthorIndex::PLAuthorIndex(size_t packageCount) : _packageAuthors(packageCount, UINT32_MAX) {}
+
+std::string PLAuthorIndex::fold(std::string const &value) {
+    NSString *string = [[NSString alloc] initWithBytes:value.data() length:value.size() encoding:NSUTF8StringEncoding];
+    NSString *folded = [string stringByFoldingWithOptions:NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch locale:nil];
+    return folded ? std::string(folded.UTF8String) : std::string();
+}
+
+std::string PLAuthorIndex::personKey(std::string const &foldedName, std::string const &email) {
+    if (!email.empty()) {
+        return "<" + fold(email) + ">";
+    }
+    return foldedName;
+}
+
+void PLAuthorIndex::addPackage(uint32_t packageID, std::string const &rfc822Value) {
+    if (packageID >= _packageAuthors.size() || rfc822Value.empty()) return;
+
+    // Same format as PLEmail, "Name <email>" with the email being optional
+    std::string name = rfc822Value;
+    std::string email;
+    size_t emailStart = rfc822Value.find(" <");
+    if (emailStart != std::string::npos && rfc822Value.find('>') == rfc822Value.size() - 1) {
+        name = rfc822Value.substr(0, emailStart);
+        email = rfc822Value.substr(emailStart + 2, rfc822Value.size() - emailStart - 3);
+    }
+
+    // Every spelling is kept so that a package's author is the one its own field names
+    std::string authorKey = name + "\n" + email;
+    auto existing = _authorIDs.find(authorKey);
+    uint32_t authorID;
+    if (existing != _authorIDs.end()) {
+        authorID = existing->second;
+    } else {
+        std::string foldedName = fold(name);
+        authorID = (uint32_t)_authors.size();
+        _authorIDs.emplace(authorKey, authorID);
+        _personAuthorIDs[personKey(foldedName, email)].push_back(authorID);
+        _authors.push_back({name, email, foldedName, {}});
+    }
+
+    // Packages usually arrive in ID order, pin updates can add them anywhere
+    std::vector<uint32_t> &packageIDs = _authors[authorID].packageIDs;
+    if (packageIDs.empty() || packageIDs.back() < packageID) {
+        packageIDs.push_back(packageID);
+    } else {
+        auto position = std::lower_bound(packageIDs.begin(), packageIDs.end(), packageID);
+        if (position == packageIDs.end() || *position != packageID) {
+            packageIDs.insert(position, packageID);
+        }
+    }
+    _packageAuthors[packageID] = authorID;
+}
+
+void PLAuthorIndex::removePackage(uint32_t packageID) {
+    if (packageID >= _packageAuthors.size() || _packageAuthors[packageID] == UINT32_MAX) return;
+
+    std::vector<uint32_t> &packageIDs = _authors[_packageAuthors[packageID]].packageIDs;
+    auto position = std::lower_bound(packageIDs.begin(), packageIDs.end(), packageID);
+    if (position != packageIDs.end() && *position == packageID) {
+        packageIDs.erase(position);
+    }
+    _packageAuthors[packageID] = UINT32_MAX;
+}
+
+std::vector<uint32_t> PLAuthorIndex::packages(std::string const &name, std::string const &email) const {
+    auto existing = _personAuthorIDs.find(personKey(fold(name), email));
+    if (existing == _personAuthorIDs.end()) {
+        return {};
+    }
+
+    std::vector<uint32_t> packageIDs;
+    for (uint32_t authorID : existing->second) {
+        std::vector<uint32_t> const &authorPackageIDs = _authors[authorID].packageIDs;
+        packageIDs.insert(packageIDs.end(), authorPackageIDs.begin(), authorPackageIDs.end());
+    }
+    if (existing->second.size() > 1) {
+        std::sort(packageIDs.begin(), packageIDs.end());
+    }
+    return packageIDs;
+}
+
+std::vector<uint32_t> PLAuthorIndex::search(std::string const &foldedQuery) const {
+    std::vector<uint32_t> packageIDs;
+    for (const Author &author : _authors) {
+        if (author.foldedName.find(foldedQuery) != std::string::npos) {
+            packageIDs.insert(packageIDs.end(), author.packageIDs.begin(), author.packageIDs.end());
+        }
+    }
+
+    std::sort(packageIDs.begin(), packageIDs.end());
+    packageIDs.erase(std::unique(packageIDs.begin(), packageIDs.end()), packageIDs.end());
+    return packageIDs;
+}
@@ -0,0 +1,143 @@
+//
+//  PLBitset.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLBitset_h
+#define PLBitset_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*!
+ A dense, resizable bitset used to keep per-package state indexed by `pkgCache::Package::ID`.
+
+ Unlike `std::vector<bool>` this exposes whole-word operations so that filters can be combined across the entire catalog without visiting each package.
+ */
+class PLBitset {
+public:
+    PLBitset() : _size(0) {}
+    explicit PLBitset(size_t size) : _words((size + 63) / 64, 0), _size(size) {}
+
+    size_t size() const { return _size; }
+
+    void resize(size_t size) {
+        _words.resize((size + 63) / 64, 0);
+        _size = size;
+        trim();
+    }
+
+    bool test(size_t index) const {
+        if (index >= _size) return false;
+        return (_words[index / 64] >> (index % 64)) & 1;
+    }
+
+    void set(size_t index, bool value = true) {
+        if (index >= _size) resize(index + 1);
+        uint64_t mask = 1ULL << (index % 64);
+        if (value) {
+            _words[index / 64] |= mask;
+        } else {
+            _words[index / 64] &= ~mask;
+        }
+    }
+
+    void reset(size_t index) {
+        set(index, false);
+    }
+
+    void clear() {
+        std::fill(_words.begin(), _words.end(), 0);
+    }
+
+    void fill() {
+        std::fill(_words.begin(), _words.end(), ~0ULL);
+        trim();
+    }
+
+    size_t count() const {
+        size_t count = 0;
+        for (uint64_t word : _words) count += __builtin_popcountll(word);
+        return count;
+    }
+
+    bool any() const {
+        for (uint64_t word : _words) {
+            if (word) return true;
+        }
+        return false;
+    }
+
+    PLBitset &operator&=(const PLBitset &other) {
+        for (size_t i = 0; i < _words.size(); i++) {
+            _words[i] &= i < other._words.size() ? other._words[i] : 0;
+        }
+        return *this;
+    }
+
+    PLBitset &operator|=(const PLBitset &other) {
+        if (other._size > _size) resize(other._size);
+        for (size_t i = 0; i < other._words.size(); i++) {
+            _words[i] |= other._words[i];
+        }
+        return *this;
+    }
+
+    PLBitset &operator^=(const PLBitset &other) {
+        if (other._size > _size) resize(other._size);
+        for (size_t i = 0; i < other._words.size(); i++) {
+            _words[i] ^= other._words[i];
+        }
+        return *this;
+    }
+
+    /*!
+     Clears every bit that is set in `other`.
+     */
+    PLBitset &subtract(const PLBitset &other) {
+        size_t words = std::min(_words.size(), other._words.size());
+        for (size_t i = 0; i < words; i++) {
+            _words[i] &= ~other._words[i];
+        }
+        return *this;
+    }
+
+    bool operator==(const PLBitset &other) const {
+        return _size == other._size && _words == other._words;
+    }
+
+    bool operator!=(const PLBitset &other) const {
+        return !(*this == other);
+    }
+
+    /*!
+     Calls `block` with the index of every set bit in ascending order.
+     */
+    template <typename Block>
+    void forEach(Block block) const {
+        for (size_t i = 0; i < _words.size(); i++) {
+            uint64_t word = _words[i];
+            while (word) {
+                size_t bit = __builtin_ctzll(word);
+                block(i * 64 + bit);
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    void trim() {
+        if (_size % 64 != 0 && !_words.empty()) {
+            _words.back() &= (1ULL << (_size % 64)) - 1;
+        }
+    }
+
+    std::vector<uint64_t> _words;
+    size_t _size;
+};
+
+#endif /* PLBitset_h */
@@ -0,0 +1,54 @@
+//
+//  PLDependencyClosure.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLDependencyClosure_h
+#define PLDependencyClosure_h
+
+#import <Plains/PLConstants.h>
+
+PL_APT_PKG_IMPORTS_BEGIN
+#include <apt-pkg/pkgcache.h>
+PL_APT_PKG_IMPORTS_END
+
+#include <memory>
+#include <vector>
+
+/*!
+ Read-only transitive dependency closures over a cache generation and its candidate table.
+
+ A closure holds every package that installing a version would pull in, found by following `Depends` and `Pre-Depends` without touching a depcache. An or-group is skipped if any alternative is already installed, otherwise it pulls in the first alternative whose candidate satisfies it, including through provides.
+
+ The closure of each candidate is memoized and shared by every package that depends on it. Dependency cycles are collapsed so that every package in a cycle shares one closure. The memo is only valid for the candidate table it was built with and has to be thrown away when candidates change. It isn't locked, a closure object must only be used from one thread at a time.
+ */
+class PLDependencyClosure {
+public:
+    typedef std::vector<map_id_t> Closure;
+
+    PLDependencyClosure(pkgCache &cache, std::vector<pkgCache::Version *> candidates);
+
+    /*!
+     The IDs of the packages that installing `version` pulls in, sorted and including the package itself.
+     */
+    std::shared_ptr<const Closure> closure(pkgCache::VerIterator const &version);
+
+    /*!
+     The candidate of a package, or `NULL` if it has none.
+     */
+    pkgCache::Version *candidate(map_id_t packageID) const {
+        return packageID < _candidates.size() ? _candidates[packageID] : NULL;
+    }
+
+private:
+    std::vector<map_id_t> dependencies(pkgCache::VerIterator const &version) const;
+    std::shared_ptr<const Closure> candidateClosure(map_id_t packageID);
+
+    pkgCache &_cache;
+    std::vector<pkgCache::Version *> _candidates;
+    std::vector<std::shared_ptr<const Closure>> _memo;
+};
+
+#endif /* PLDependencyClosure_h */
@@ -0,0 +1,147 @@
+//
+//  PLDependencyClosure.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLDependencyClosure.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+static const map_id_t PLNoPackage = std::numeric_limits<map_id_t>::max();
+
+PLDependencyClosure::PLDependencyClosure(pkgCache &cache, std::vector<pkgCache::Version *> candidates) : _cache(cache), _candidates(std::move(candidates)), _memo(_candidates.size()) {}
+
+std::vector<map_id_t> PLDependencyClosure::dependencies(pkgCache::VerIterator const &version) const {
+    std::vector<map_id_t> targets;
+
+    pkgCache::DepIterator dep = version.DependsList();
+    while (!dep.end()) {
+        pkgCache::DepIterator start;
+        pkgCache::DepIterator end;
+        dep.GlobOr(start, end);
+        if (start->Type != pkgCache::Dep::Depends && start->Type != pkgCache::Dep::PreDepends) continue;
+
+        bool satisfied = false;
+        map_id_t chosen = PLNoPackage;
+        while (!satisfied) {
+            // AllTargets already applies the version requirement and includes providing versions
+            std::unique_ptr<pkgCache::Version *[]> versions(start.AllTargets());
+            for (pkgCache::Version **target = versions.get(); *target != NULL; target++) {
+                pkgCache::VerIterator targetVersion(_cache, *target);
+                pkgCache::PkgIterator parent = targetVersion.ParentPkg();
+                if (parent.CurrentVer() == targetVersion) {
+                    satisfied = true;
+                    break;
+                }
+                if (chosen == PLNoPackage && candidate(parent->ID) == *target) {
+                    chosen = parent->ID;
+                }
+            }
+
+            if (start == end) break;
+            start++;
+        }
+
+        if (!satisfied && chosen != PLNoPackage) targets.push_back(chosen);
+    }
+
+    return targets;
+}
+
+std::shared_ptr<const PLDependencyClosure::Closure> PLDependencyClosure::closure(pkgCache::VerIterator const &version) {
+    map_id_t packageID = version.ParentPkg()->ID;
+    if (candidate(packageID) == (pkgCache::Version *)version) {
+        return candidateClosure(packageID);
+    }
+
+    // Other versions aren't memoized, but what they pull in is
+    auto closure = std::make_shared<Closure>(1, packageID);
+    for (map_id_t dependency : dependencies(version)) {
+        std::shared_ptr<const Closure> dependencyClosure = candidateClosure(dependency);
+        closure->insert(closure->end(), dependencyClosure->begin(), dependencyClosure->end());
+    }
+    std::sort(closure->begin(), closure->end());
+    closure->erase(std::unique(closure->begin(), closure->end()), closure->end());
+    return closure;
+}
+
+std::shared_ptr<const PLDependencyClosure::Closure> PLDependencyClosure::candidateClosure(map_id_t root) {
+    if (_memo[root]) return _memo[root];
+
+    // Tarjan's algorithm, iteratively so that long dependency chains can't overflow the stack. Packages in the same strongly connected component depend on each other and so share one closure.
+    struct Node {
+        size_t index;
+        size_t lowlink;
+        bool onStack;
+        std::vector<map_id_t> edges;
+    };
+    std::unordered_map<map_id_t, Node> nodes;
+    std::vector<std::pair<map_id_t, size_t>> frames;
+    std::vector<map_id_t> stack;
+    size_t nextIndex = 0;
+
+    auto visit = [&](map_id_t packageID) {
+        pkgCache::VerIterator version(_cache, _candidates[packageID]);
+        nodes[packageID] = {nextIndex, nextIndex, true, dependencies(version)};
+        nextIndex++;
+        stack.push_back(packageID);
+        frames.emplace_back(packageID, 0);
+    };
+
+    visit(root);
+    while (!frames.empty()) {
+        map_id_t packageID = frames.back().first;
+        size_t &nextEdge = frames.back().second;
+        Node &node = nodes[packageID];
+
+        if (nextEdge < node.edges.size()) {
+            map_id_t target = node.edges[nextEdge++];
+            if (_memo[target]) continue;
+
+            auto visited = nodes.find(target);
+            if (visited == nodes.end()) {
+                visit(target);
+            } else if (visited->second.onStack) {
+                node.lowlink = std::min(node.lowlink, visited->second.index);
+            }
+            continue;
+        }
+
+        if (node.lowlink == node.index) {
+            std::vector<map_id_t> component;
+            map_id_t popped;
+            do {
+                popped = stack.back();
+                stack.pop_back();
+                nodes[popped].onStack = false;
+                component.push_back(popped);
+            } while (popped != packageID);
+
+            // Every edge that leaves the component points at a finished closure by now
+            auto closure = std::make_shared<Closure>(component);
+            for (map_id_t member : component) {
+                for (map_id_t target : nodes[member].edges) {
+                    if (_memo[target]) closure->insert(closure->end(), _memo[target]->begin(), _memo[target]->end());
+                }
+            }
+            std::sort(closure->begin(), closure->end());
+            closure->erase(std::unique(closure->begin(), closure->end()), closure->end());
+            for (map_id_t member : component) {
+                _memo[member] = closure;
+            }
+        }
+
+        size_t lowlink = node.lowlink;
+        frames.pop_back();
+        if (!frames.empty()) {
+            Node &parent = nodes[frames.back().first];
+            parent.lowlink = std::min(parent.lowlink, lowlink);
+        }
+    }
+
+    return _memo[root];
+}
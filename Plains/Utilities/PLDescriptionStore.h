@@ -0,0 +1,116 @@
+//
+//  PLDescriptionStore.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLDescriptionStore_h
+#define PLDescriptionStore_h
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+typedef struct ZSTD_DDict_s ZSTD_DDict;
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+
+/*!
+ Short and long descriptions of every package in a cache generation, kept in memory as independently compressed zstd blocks.
+
+ Descriptions are appended with `addPackage` and compressed once `finish` is called. Blocks share a raw content dictionary sampled from the descriptions themselves so that small blocks still compress well, and because each block can be decompressed on its own, searches scan them in parallel. Package IDs are `pkgCache::Package::ID` values.
+ */
+class PLDescriptionStore {
+public:
+    explicit PLDescriptionStore(size_t packageCount);
+    ~PLDescriptionStore();
+
+    PLDescriptionStore(PLDescriptionStore const &) = delete;
+    PLDescriptionStore &operator=(PLDescriptionStore const &) = delete;
+
+    /*!
+     Turn the output of `pkgRecords::Parser::LongDesc()` into the text shown to users in a single pass.
+
+     The summary line is dropped, the leading space of every continuation line is removed and lines containing only `.` become blank lines.
+     */
+    static std::string formatLongDescription(std::string const &description);
+
+    /*!
+     Add the descriptions of a package. Must be called before `finish`.
+     */
+    void addPackage(uint32_t packageID, std::string const &shortDescription, std::string const &longDescription);
+
+    /*!
+     Compress everything that has been added. The store is read only afterwards.
+     */
+    void finish();
+
+    /*!
+     Replace the descriptions of a package after `finish`, such as when a pin changes its candidate.
+
+     Replacements are kept uncompressed next to the blocks, they are only expected for a handful of packages until the store is rebuilt by the next import.
+     */
+    void replacePackage(uint32_t packageID, std::string const &shortDescription, std::string const &longDescription);
+
+    /*!
+     Read the descriptions of a package.
+
+     - returns: Whether or not the package has an entry in the store.
+     */
+    bool lookup(uint32_t packageID, std::string &shortDescription, std::string &longDescription);
+
+    /*!
+     Scan every short description in parallel.
+
+     - parameter matches: Called concurrently with a package ID and its short description, returns whether or not the package should be included.
+     - returns: The matching package IDs in ascending order.
+     */
+    std::vector<uint32_t> search(std::function<bool(uint32_t packageID, const char *description, size_t length)> const &matches) const;
+
+    /*!
+     Memory used by the compressed blocks, the dictionary, the entry table and any uncompressed replacements, in bytes.
+     */
+    size_t memoryUsage() const;
+
+    /*!
+     Size of all descriptions before compression, in bytes.
+     */
+    size_t uncompressedSize() const { return _uncompressedSize; }
+
+private:
+    struct Entry {
+        uint32_t block;
+        uint32_t offset;
+        uint32_t shortLength;
+        uint32_t longLength;
+    };
+
+    struct Block {
+        std::string data;
+        uint32_t size;
+        bool compressed;
+        std::vector<uint32_t> packageIDs;
+    };
+
+    bool decompress(ZSTD_DCtx *context, Block const &block, std::string &output) const;
+
+    std::vector<Entry> _entries;
+    std::vector<Block> _blocks;
+    size_t _uncompressedSize;
+    bool _finished;
+    ZSTD_DDict *_dictionary;
+
+    mutable std::mutex _replacementsMutex;
+    std::unordered_map<uint32_t, std::pair<std::string, std::string>> _replacements;
+
+    std::mutex _mutex;
+    ZSTD_DCtx *_context;
+    uint32_t _lastBlock;
+    std::string _lastBlockData;
+};
+
+#endif /* PLDescriptionStore_h */
@@ -0,0 +1,209 @@
+//
+//  PLDescriptionStore.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLDescriptionStore.h"
+
+#import <Foundation/Foundation.h>
+
+#include <zstd.h>
+
+#include <algorithm>
+
+// Small blocks keep single lookups cheap, the shared dictionary makes up for the lost context
+static const size_t PLDescriptionStoreBlockSize = 16 * 1024;
+static const size_t PLDescriptionStoreDictionarySize = 32 * 1024;
+static const int PLDescriptionStoreCompressionLevel = 9;
+
+PLDescriptionStore::PLDescriptionStore(size_t packageCount) : _entries(packageCount, {UINT32_MAX, 0, 0, 0}), _uncompressedSize(0), _finished(false), _dictionary(nullptr), _context(nullptr), _lastBlock(UINT32_MAX) {}
+
+PLDescriptionStore::~PLDescriptionStore() {
+    ZSTD_freeDDict(_dictionary);
+    ZSTD_freeDCtx(_context);
+}
+
+std::string PLDescriptionStore::formatLongDescription(std::string const &description) {
+    size_t lineStart = description.find('\n');
+    if (lineStart == std::string::npos) {
+        return description;
+    }
+
+    std::string formatted;
+    formatted.reserve(description.size() - lineStart);
+    lineStart++;
+    while (lineStart < description.size()) {
+        size_t lineEnd = description.find('\n', lineStart);
+        if (lineEnd == std::string::npos) lineEnd = description.size();
+
+        size_t contentStart = lineStart;
+        if (contentStart < lineEnd && description[contentStart] == ' ') contentStart++;
+
+        if (!formatted.empty()) formatted.push_back('\n');
+        if (!(lineEnd - contentStart == 1 && description[contentStart] == '.')) {
+            formatted.append(description, contentStart, lineEnd - contentStart);
+        }
+        lineStart = lineEnd + 1;
+    }
+    return formatted;
+}
+
+void PLDescriptionStore::addPackage(uint32_t packageID, std::string const &shortDescription, std::string const &longDescription) {
+    if (_finished || packageID >= _entries.size()) return;
+
+    if (_blocks.empty() || _blocks.back().data.size() >= PLDescriptionStoreBlockSize) {
+        _blocks.push_back({std::string(), 0, false, {}});
+    }
+
+    Block &block = _blocks.back();
+    _entries[packageID] = {(uint32_t)(_blocks.size() - 1), (uint32_t)block.data.size(), (uint32_t)shortDescription.size(), (uint32_t)longDescription.size()};
+    block.data.append(shortDescription);
+    block.data.append(longDescription);
+    block.packageIDs.push_back(packageID);
+    _uncompressedSize += shortDescription.size() + longDescription.size();
+}
+
+void PLDescriptionStore::finish() {
+    if (_finished) return;
+    _finished = true;
+    if (_blocks.empty()) return;
+
+    // zdict isn't vendored so there's no trainer, a raw content dictionary sampled evenly across the catalog gets most of the benefit
+    std::string dictionary;
+    size_t sampleSize = std::max<size_t>(PLDescriptionStoreDictionarySize / _blocks.size(), 256);
+    for (Block const &block : _blocks) {
+        if (dictionary.size() >= PLDescriptionStoreDictionarySize) break;
+        dictionary.append(block.data, 0, std::min(sampleSize, block.data.size()));
+    }
+
+    ZSTD_CDict *compressionDictionary = ZSTD_createCDict(dictionary.data(), dictionary.size(), PLDescriptionStoreCompressionLevel);
+    _dictionary = ZSTD_createDDict(dictionary.data(), dictionary.size());
+
+    Block *blocks = _blocks.data();
+    dispatch_apply(_blocks.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+        Block &block = blocks[index];
+        std::string compressed(ZSTD_compressBound(block.data.size()), '\0');
+
+        ZSTD_CCtx *context = ZSTD_createCCtx();
+        size_t length = ZSTD_compress_usingCDict(context, &compressed[0], compressed.size(), block.data.data(), block.data.size(), compressionDictionary);
+        ZSTD_freeCCtx(context);
+
+        block.size = (uint32_t)block.data.size();
+        if (ZSTD_isError(length)) {
+            // Keep the block uncompressed rather than losing the descriptions in it
+            return;
+        }
+        compressed.resize(length);
+        compressed.shrink_to_fit();
+        block.data.swap(compressed);
+        block.compressed = true;
+    });
+
+    ZSTD_freeCDict(compressionDictionary);
+}
+
+bool PLDescriptionStore::decompress(ZSTD_DCtx *context, Block const &block, std::string &output) const {
+    if (!block.compressed) {
+        output = block.data;
+        return true;
+    }
+
+    output.resize(block.size);
+    size_t length = ZSTD_decompress_usingDDict(context, &output[0], output.size(), block.data.data(), block.data.size(), _dictionary);
+    return !ZSTD_isError(length) && length == block.size;
+}
+
+void PLDescriptionStore::replacePackage(uint32_t packageID, std::string const &shortDescription, std::string const &longDescription) {
+    if (!_finished || packageID >= _entries.size()) return;
+
+    std::lock_guard<std::mutex> lock(_replacementsMutex);
+    _replacements[packageID] = std::make_pair(shortDescription, longDescription);
+}
+
+bool PLDescriptionStore::lookup(uint32_t packageID, std::string &shortDescription, std::string &longDescription) {
+    if (!_finished || packageID >= _entries.size()) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(_replacementsMutex);
+        auto replacement = _replacements.find(packageID);
+        if (replacement != _replacements.end()) {
+            shortDescription = replacement->second.first;
+            longDescription = replacement->second.second;
+            return true;
+        }
+    }
+    if (_entries[packageID].block == UINT32_MAX) return false;
+
+    Entry const &entry = _entries[packageID];
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_lastBlock != entry.block) {
+        if (!_context) _context = ZSTD_createDCtx();
+        if (!decompress(_context, _blocks[entry.block], _lastBlockData)) {
+            _lastBlock = UINT32_MAX;
+            return false;
+        }
+        _lastBlock = entry.block;
+    }
+
+    shortDescription.assign(_lastBlockData, entry.offset, entry.shortLength);
+    longDescription.assign(_lastBlockData, entry.offset + entry.shortLength, entry.longLength);
+    return true;
+}
+
+std::vector<uint32_t> PLDescriptionStore::search(std::function<bool(uint32_t packageID, const char *description, size_t length)> const &matches) const {
+    std::vector<std::vector<uint32_t>> results(_blocks.size());
+    if (!_finished) return {};
+
+    std::unordered_map<uint32_t, std::pair<std::string, std::string>> replacements;
+    {
+        std::lock_guard<std::mutex> lock(_replacementsMutex);
+        replacements = _replacements;
+    }
+
+    std::vector<uint32_t> *blockResults = results.data();
+    const Block *blocks = _blocks.data();
+    const auto *replaced = &replacements;
+    dispatch_apply(_blocks.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+        ZSTD_DCtx *context = ZSTD_createDCtx();
+        std::string data;
+        if (decompress(context, blocks[index], data)) {
+            for (uint32_t packageID : blocks[index].packageIDs) {
+                if (replaced->find(packageID) != replaced->end()) continue;
+
+                Entry const &entry = _entries[packageID];
+                if (matches(packageID, data.data() + entry.offset, entry.shortLength)) {
+                    blockResults[index].push_back(packageID);
+                }
+            }
+        }
+        ZSTD_freeDCtx(context);
+    });
+
+    std::vector<uint32_t> packageIDs;
+    for (std::vector<uint32_t> const &blockResult : results) {
+        packageIDs.insert(packageIDs.end(), blockResult.begin(), blockResult.end());
+    }
+    for (auto const &replacement : replacements) {
+        std::string const &description = replacement.second.first;
+        if (matches(replacement.first, description.data(), description.size())) {
+            packageIDs.push_back(replacement.first);
+        }
+    }
+    std::sort(packageIDs.begin(), packageIDs.end());
+    return packageIDs;
+}
+
+size_t PLDescriptionStore::memoryUsage() const {
+    size_t usage = _entries.capacity() * sizeof(Entry) + ZSTD_sizeof_DDict(_dictionary);
+    for (Block const &block : _blocks) {
+        usage += block.data.capacity() + block.packageIDs.capacity() * sizeof(uint32_t);
+    }
+
+    std::lock_guard<std::mutex> lock(_replacementsMutex);
+    for (auto const &replacement : _replacements) {
+        usage += sizeof(replacement) + replacement.second.first.capacity() + replacement.second.second.capacity();
+    }
+    return usage;
+}
@@ -0,0 +1,55 @@
+//
+//  PLGenerationSummary.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLGenerationSummary_h
+#define PLGenerationSummary_h
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+ Packages that were added, removed or changed version between two cache generations, identified by name.
+ */
+struct PLChangeSet {
+    std::vector<std::string> added;
+    std::vector<std::string> removed;
+    std::vector<std::string> updated;
+
+    bool empty() const { return added.empty() && removed.empty() && updated.empty(); }
+};
+
+/*!
+ The name and candidate version of every package in a cache generation.
+
+ Unlike package IDs and iterators, names stay meaningful after the cache they came from has been closed, so a summary can be kept around and diffed against the next generation.
+ */
+class PLGenerationSummary {
+public:
+    void reserve(size_t count) { _packages.reserve(count); }
+
+    void addPackage(std::string name, std::string version) {
+        _packages.emplace_back(std::move(name), std::move(version));
+    }
+
+    /*!
+     Sort the summary so that it can be diffed. Must be called after every package has been added.
+     */
+    void finish();
+
+    bool empty() const { return _packages.empty(); }
+
+    /*!
+     The changes from `previous` to this generation.
+     */
+    PLChangeSet diff(PLGenerationSummary const &previous) const;
+
+private:
+    std::vector<std::pair<std::string, std::string>> _packages;
+};
+
+#endif /* PLGenerationSummary_h */
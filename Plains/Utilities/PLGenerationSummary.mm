@@ -0,0 +1,38 @@
+//
+//  PLGenerationSummary.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLGenerationSummary.h"
+
+#include <algorithm>
+
+void PLGenerationSummary::finish() {
+    std::sort(_packages.begin(), _packages.end());
+}
+
+PLChangeSet PLGenerationSummary::diff(PLGenerationSummary const &previous) const {
+    PLChangeSet changes;
+
+    // Both summaries are sorted by name so a single merge pass finds every difference
+    auto current = _packages.begin();
+    auto old = previous._packages.begin();
+    while (current != _packages.end() || old != previous._packages.end()) {
+        if (old == previous._packages.end() || (current != _packages.end() && current->first < old->first)) {
+            changes.added.push_back(current->first);
+            current++;
+        } else if (current == _packages.end() || old->first < current->first) {
+            changes.removed.push_back(old->first);
+            old++;
+        } else {
+            if (current->second != old->second) {
+                changes.updated.push_back(current->first);
+            }
+            current++;
+            old++;
+        }
+    }
+    return changes;
+}
@@ -0,0 +1,63 @@
+//
+//  PLProvidesIndex.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLProvidesIndex_h
+#define PLProvidesIndex_h
+
+#import <Plains/PLConstants.h>
+
+PL_APT_PKG_IMPORTS_BEGIN
+#include <apt-pkg/pkgcache.h>
+PL_APT_PKG_IMPORTS_END
+
+#include <utility>
+#include <vector>
+
+/*!
+ The versions that provide each package name in a cache generation.
+
+ Providers are read from every `ProvidesList` chain once and stored contiguously per provided package, with installed providers first, so looking them up is a single slice.
+ */
+class PLProvidesIndex {
+public:
+    struct Provider {
+        pkgCache::Version *version;
+        bool installed;
+    };
+
+    explicit PLProvidesIndex(pkgCache &cache);
+
+    typedef std::vector<Provider>::const_iterator Iterator;
+
+    /*!
+     The versions that provide `packageID`, installed ones first. The range is empty if nothing provides it.
+     */
+    std::pair<Iterator, Iterator> providers(map_id_t packageID) const {
+        if (packageID >= _packageCount) return std::make_pair(_providers.end(), _providers.end());
+        return std::make_pair(_providers.begin() + _offsets[packageID], _providers.begin() + _offsets[packageID + 1]);
+    }
+
+    bool hasProviders(map_id_t packageID) const {
+        auto range = providers(packageID);
+        return range.first != range.second;
+    }
+
+    /*!
+     The installed version that provides `packageID`, or `NULL` if none is installed.
+     */
+    pkgCache::Version *installedProvider(map_id_t packageID) const {
+        auto range = providers(packageID);
+        return range.first != range.second && range.first->installed ? range.first->version : NULL;
+    }
+
+private:
+    size_t _packageCount;
+    std::vector<uint32_t> _offsets;
+    std::vector<Provider> _providers;
+};
+
+#endif /* PLProvidesIndex_h */
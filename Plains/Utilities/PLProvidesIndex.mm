@@ -0,0 +1,36 @@
+//
+//  PLProvidesIndex.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLProvidesIndex.h"
+
+#include <algorithm>
+
+PLProvidesIndex::PLProvidesIndex(pkgCache &cache) : _packageCount(cache.Head().PackageCount), _offsets(_packageCount + 1, 0) {
+    // Packages are iterated in hash order rather than ID order, so count first and then fill each slice
+    for (pkgCache::PkgIterator package = cache.PkgBegin(); !package.end(); package++) {
+        for (pkgCache::PrvIterator provides = package.ProvidesList(); !provides.end(); provides++) {
+            _offsets[package->ID + 1]++;
+        }
+    }
+    for (size_t packageID = 0; packageID < _packageCount; packageID++) {
+        _offsets[packageID + 1] += _offsets[packageID];
+    }
+
+    _providers.resize(_offsets[_packageCount]);
+    std::vector<uint32_t> next(_offsets.begin(), _offsets.end() - 1);
+    for (pkgCache::PkgIterator package = cache.PkgBegin(); !package.end(); package++) {
+        if (package->ProvidesList == 0) continue;
+
+        for (pkgCache::PrvIterator provides = package.ProvidesList(); !provides.end(); provides++) {
+            pkgCache::VerIterator version = provides.OwnerVer();
+            _providers[next[package->ID]++] = {version, provides.OwnerPkg().CurrentVer() == version};
+        }
+        std::stable_partition(_providers.begin() + _offsets[package->ID], _providers.begin() + _offsets[package->ID + 1], [](Provider const &provider) {
+            return provider.installed;
+        });
+    }
+}
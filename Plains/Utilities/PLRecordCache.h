@@ -0,0 +1,165 @@
+//
+//  PLRecordCache.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLRecordCache_h
+#define PLRecordCache_h
+
+#import <Plains/PLConstants.h>
+
+PL_APT_PKG_IMPORTS_BEGIN
+#include <apt-pkg/pkgcache.h>
+#include <apt-pkg/cacheiterators.h>
+#include <apt-pkg/pkgrecords.h>
+PL_APT_PKG_IMPORTS_END
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*!
+ Caches the control stanza of each version the first time it is read from `pkgRecords`, along with a table of where each field starts and ends.
+
+ Subsequent field reads are slices of the cached stanza and never go back to the Packages file. The fields in `knownFields` are found through a slot table without scanning the stanza. The cache is bound to a single `pkgCache` and should be recreated whenever the cache is reopened.
+
+ Stanzas are kept until their total size passes the limit the cache was created with, then the oldest ones are dropped and read again if they're needed.
+ */
+class PLRecordCache {
+public:
+    /*!
+     A copy of a single control stanza with the location of each of its fields.
+     */
+    class Record {
+    public:
+        struct Field {
+            uint32_t keyStart;
+            uint32_t keyLength;
+            uint32_t valueStart;
+            uint32_t valueLength;
+        };
+
+        /*!
+         The fields Plains and its clients read most, each record remembers where they are.
+         */
+        static const size_t knownFieldCount = 12;
+        static const std::array<const char *, knownFieldCount> knownFields;
+
+        /*!
+         The slot of a field in `knownFields`, compared case insensitively, or `-1` if it isn't one of them. Look this up once when reading the same field from many records.
+         */
+        static int slot(const char *key, size_t keyLength);
+
+        explicit Record(const char *start, const char *stop);
+
+        /*!
+         Find the value of a field.
+
+         - parameter key: The name of the field, compared case insensitively.
+         - parameter start: Set to the beginning of the value if the field exists.
+         - parameter length: Set to the length of the value if the field exists.
+         - returns: Whether or not the field exists.
+         */
+        bool find(const char *key, size_t keyLength, const char *&start, size_t &length) const {
+            return find(slot(key, keyLength), key, keyLength, start, length);
+        }
+
+        /*!
+         Find the value of a field whose slot has already been looked up, fields without a slot are found by scanning the stanza.
+         */
+        bool find(int slot, const char *key, size_t keyLength, const char *&start, size_t &length) const;
+
+        /*!
+         Memory used by the record in bytes.
+         */
+        size_t size() const {
+            return sizeof(Record) + _text.capacity() + _fields.capacity() * sizeof(Field);
+        }
+
+        const std::string &text() const { return _text; }
+        const std::vector<Field> &fields() const { return _fields; }
+
+    private:
+        std::string _text;
+        std::vector<Field> _fields;
+        std::array<uint16_t, knownFieldCount> _slots;
+    };
+
+    /*!
+     - parameter limit: The number of bytes of stanzas to keep before the oldest are dropped.
+     */
+    PLRecordCache(pkgCache &cache, pkgRecords &records, size_t limit);
+
+    /*!
+     Whether or not `version` belongs to the cache this record cache was created for.
+     */
+    bool owns(pkgCache::VerIterator const &version) const {
+        return version.Cache() == &_cache;
+    }
+
+    /*!
+     Whether or not the stanza of `version` has already been cached.
+     */
+    bool contains(pkgCache::VerIterator const &version);
+
+    /*!
+     Get the stanza of `version`, reading and parsing it from the version's first file on first access.
+
+     The returned record stays valid for as long as it is held, even if the cache drops it.
+     */
+    std::shared_ptr<const Record> lookup(pkgCache::VerIterator const &version);
+
+    /*!
+     Get the stanzas of several versions at once.
+
+     Stanzas that are not cached yet are read in package file and offset order so that the Packages files are read sequentially.
+
+     - returns: The records in the same order as `versions`, with `nullptr` for versions that have no record.
+     */
+    std::vector<std::shared_ptr<const Record>> lookup(std::vector<pkgCache::VerIterator> const &versions);
+
+    /*!
+     Read the stanzas of several versions into the cache in package file and offset order.
+
+     Unlike the batch `lookup` the lock is only held for one stanza at a time, so readers on other threads are never blocked for the whole batch.
+
+     - parameter shouldContinue: Called before each stanza is read, returning `false` stops the prefetch.
+     */
+    void prefetch(std::vector<pkgCache::VerIterator> const &versions, std::function<bool()> const &shouldContinue);
+
+    /*!
+     Visit the records of several versions in package file and offset order without caching them.
+
+     Used to build catalog wide indexes without copying every stanza into memory. The lock is held for one record at a time while `block` runs.
+
+     - parameter block: Called with the index in `versions` and the parser positioned at that version's record, returning `false` stops the visit before the next record is read.
+     */
+    void visit(std::vector<pkgCache::VerIterator> const &versions, std::function<bool(size_t index, pkgRecords::Parser &parser)> const &block);
+
+    /*!
+     Run `block` with exclusive access to the underlying `pkgRecords`.
+
+     `pkgRecords` is not thread safe, anything that reads from it directly while the cache may be in use on another thread has to go through here.
+     */
+    void withRecords(std::function<void(pkgRecords &records)> const &block);
+
+private:
+    std::shared_ptr<const Record> lookupLocked(pkgCache::VerIterator const &version);
+    std::vector<size_t> fileOrder(std::vector<pkgCache::VerIterator> const &versions) const;
+
+    pkgCache &_cache;
+    pkgRecords &_records;
+    std::mutex _mutex;
+    std::vector<std::shared_ptr<const Record>> _entries;
+    std::deque<uint32_t> _order;
+    size_t _size;
+    size_t _limit;
+};
+
+#endif /* PLRecordCache_h */
@@ -0,0 +1,205 @@
+//
+//  PLRecordCache.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLRecordCache.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+const std::array<const char *, PLRecordCache::Record::knownFieldCount> PLRecordCache::Record::knownFields = {
+    "Package", "Name", "Section", "Author", "Maintainer", "Tag", "Depiction", "Native-Depiction", "SileoDepiction", "Icon", "Header", "Homepage",
+};
+
+static const uint16_t PLRecordNoField = UINT16_MAX;
+
+int PLRecordCache::Record::slot(const char *key, size_t keyLength) {
+    // Known fields are short, anything longer can't be one of them
+    char folded[32];
+    if (keyLength >= sizeof(folded)) return -1;
+    for (size_t i = 0; i < keyLength; i++) {
+        folded[i] = tolower((unsigned char)key[i]);
+    }
+
+    static const std::unordered_map<std::string, int> slots = [] {
+        std::unordered_map<std::string, int> slots;
+        for (size_t i = 0; i < knownFields.size(); i++) {
+            std::string field = knownFields[i];
+            std::transform(field.begin(), field.end(), field.begin(), [](unsigned char c) { return tolower(c); });
+            slots.emplace(field, (int)i);
+        }
+        return slots;
+    }();
+    auto existing = slots.find(std::string(folded, keyLength));
+    return existing == slots.end() ? -1 : existing->second;
+}
+
+PLRecordCache::Record::Record(const char *start, const char *stop) : _text(start, stop - start) {
+    _slots.fill(PLRecordNoField);
+
+    const char *base = _text.data();
+    const char *end = base + _text.size();
+    const char *line = base;
+
+    while (line < end) {
+        const char *lineEnd = (const char *)memchr(line, '\n', end - line);
+        if (!lineEnd) lineEnd = end;
+
+        // Continuation lines belong to the previous field, blank lines end the stanza
+        if (line == lineEnd || *line == ' ' || *line == '\t') {
+            if (line == lineEnd) break;
+            if (!_fields.empty()) {
+                Field &previous = _fields.back();
+                previous.valueLength = (uint32_t)(lineEnd - (base + previous.valueStart));
+            }
+            line = lineEnd + 1;
+            continue;
+        }
+
+        const char *colon = (const char *)memchr(line, ':', lineEnd - line);
+        if (colon) {
+            const char *value = colon + 1;
+            while (value < lineEnd && (*value == ' ' || *value == '\t')) value++;
+
+            // The first occurrence wins, the same as the scan in find
+            int fieldSlot = slot(line, colon - line);
+            if (fieldSlot >= 0 && _slots[fieldSlot] == PLRecordNoField && _fields.size() < PLRecordNoField) {
+                _slots[fieldSlot] = (uint16_t)_fields.size();
+            }
+            _fields.push_back({(uint32_t)(line - base), (uint32_t)(colon - line), (uint32_t)(value - base), (uint32_t)(lineEnd - value)});
+        }
+        line = lineEnd + 1;
+    }
+
+    // Match pkgTagSection and drop trailing whitespace from every value
+    for (Field &field : _fields) {
+        while (field.valueLength > 0 && isspace(base[field.valueStart + field.valueLength - 1])) {
+            field.valueLength--;
+        }
+    }
+}
+
+bool PLRecordCache::Record::find(int slot, const char *key, size_t keyLength, const char *&start, size_t &length) const {
+    const char *base = _text.data();
+    if (slot >= 0 && (size_t)slot < _slots.size()) {
+        if (_slots[slot] == PLRecordNoField) return false;
+
+        const Field &field = _fields[_slots[slot]];
+        start = base + field.valueStart;
+        length = field.valueLength;
+        return true;
+    }
+
+    for (const Field &field : _fields) {
+        if (field.keyLength != keyLength) continue;
+        if (strncasecmp(base + field.keyStart, key, keyLength) != 0) continue;
+
+        start = base + field.valueStart;
+        length = field.valueLength;
+        return true;
+    }
+    return false;
+}
+
+PLRecordCache::PLRecordCache(pkgCache &cache, pkgRecords &records, size_t limit) : _cache(cache), _records(records), _size(0), _limit(limit) {
+    _entries.resize(cache.Head().VersionCount);
+}
+
+bool PLRecordCache::contains(pkgCache::VerIterator const &version) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !version.end() && version->ID < _entries.size() && _entries[version->ID] != nullptr;
+}
+
+std::shared_ptr<const PLRecordCache::Record> PLRecordCache::lookup(pkgCache::VerIterator const &version) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return lookupLocked(version);
+}
+
+std::vector<size_t> PLRecordCache::fileOrder(std::vector<pkgCache::VerIterator> const &versions) const {
+    std::vector<size_t> order;
+    order.reserve(versions.size());
+    for (size_t i = 0; i < versions.size(); i++) {
+        if (!versions[i].end() && !versions[i].FileList().end()) {
+            order.push_back(i);
+        }
+    }
+
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        pkgCache::VerFileIterator fileA = versions[a].FileList();
+        pkgCache::VerFileIterator fileB = versions[b].FileList();
+        if (fileA.File()->ID != fileB.File()->ID) {
+            return fileA.File()->ID < fileB.File()->ID;
+        }
+        return fileA->Offset < fileB->Offset;
+    });
+    return order;
+}
+
+std::vector<std::shared_ptr<const PLRecordCache::Record>> PLRecordCache::lookup(std::vector<pkgCache::VerIterator> const &versions) {
+    std::vector<size_t> order = fileOrder(versions);
+
+    std::vector<std::shared_ptr<const Record>> results(versions.size());
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (size_t index : order) {
+        results[index] = lookupLocked(versions[index]);
+    }
+    return results;
+}
+
+void PLRecordCache::prefetch(std::vector<pkgCache::VerIterator> const &versions, std::function<bool()> const &shouldContinue) {
+    for (size_t index : fileOrder(versions)) {
+        if (!shouldContinue()) return;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        lookupLocked(versions[index]);
+    }
+}
+
+void PLRecordCache::visit(std::vector<pkgCache::VerIterator> const &versions, std::function<bool(size_t index, pkgRecords::Parser &parser)> const &block) {
+    for (size_t index : fileOrder(versions)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!block(index, _records.Lookup(versions[index].FileList()))) return;
+    }
+}
+
+void PLRecordCache::withRecords(std::function<void(pkgRecords &records)> const &block) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    block(_records);
+}
+
+std::shared_ptr<const PLRecordCache::Record> PLRecordCache::lookupLocked(pkgCache::VerIterator const &version) {
+    if (version.end() || !owns(version) || version->ID >= _entries.size()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<const Record> entry = _entries[version->ID];
+    if (entry) return entry;
+
+    pkgCache::VerFileIterator file = version.FileList();
+    if (file.end()) return nullptr;
+
+    // pkgRecords reuses its buffer for every lookup so the stanza has to be copied out
+    pkgRecords::Parser &parser = _records.Lookup(file);
+    const char *start;
+    const char *stop;
+    parser.GetRec(start, stop);
+    entry = std::make_shared<const Record>(start, stop);
+    _entries[version->ID] = entry;
+    _order.push_back(version->ID);
+    _size += entry->size();
+
+    // Drop the oldest stanzas first, whoever still holds one keeps it alive
+    while (_size > _limit && _order.size() > 1) {
+        std::shared_ptr<const Record> &oldest = _entries[_order.front()];
+        _size -= oldest->size();
+        oldest.reset();
+        _order.pop_front();
+    }
+    return entry;
+}
@@ -0,0 +1,63 @@
+//
+//  PLReverseDependencyIndex.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLReverseDependencyIndex_h
+#define PLReverseDependencyIndex_h
+
+#import <Plains/PLConstants.h>
+#import "PLBitset.h"
+
+PL_APT_PKG_IMPORTS_BEGIN
+#include <apt-pkg/pkgcache.h>
+PL_APT_PKG_IMPORTS_END
+
+#include <vector>
+
+/*!
+ Which installed packages rely on which for a cache generation.
+
+ Every `Depends` and `Pre-Depends` or-group of every installed version is reduced to the installed packages that satisfy it, directly or through provides, and indexed by those packages. Or-groups that nothing installed satisfies are already broken and are left out.
+
+ `Conflicts` and `Breaks` of installed versions are indexed by the package name they target, so checking whether a new version clashes with anything installed only looks at the entries for its own name and the names it provides.
+ */
+class PLReverseDependencyIndex {
+public:
+    explicit PLReverseDependencyIndex(pkgCache &cache);
+
+    /*!
+     The installed packages with a dependency that `packageID` helps satisfy, in package ID order.
+     */
+    std::vector<map_id_t> dependents(map_id_t packageID) const;
+
+    /*!
+     The installed packages that would be left with an unsatisfied dependency if `packageIDs` were removed, following each of them as if it were removed too. The removed packages themselves are not included.
+     */
+    PLBitset removalImpact(std::vector<map_id_t> const &packageIDs) const;
+
+    /*!
+     The `Conflicts` and `Breaks` of installed versions that name `packageID`, whatever version they require.
+     */
+    std::vector<pkgCache::Dependency *> const &conflicts(map_id_t packageID) const {
+        static const std::vector<pkgCache::Dependency *> none;
+        return packageID < _conflictsByTarget.size() ? _conflictsByTarget[packageID] : none;
+    }
+
+private:
+    struct Group {
+        map_id_t dependent;
+        uint32_t satisfiersStart;
+        uint32_t satisfiersCount;
+    };
+
+    size_t _packageCount;
+    std::vector<Group> _groups;
+    std::vector<map_id_t> _satisfiers;
+    std::vector<std::vector<uint32_t>> _groupsBySatisfier;
+    std::vector<std::vector<pkgCache::Dependency *>> _conflictsByTarget;
+};
+
+#endif /* PLReverseDependencyIndex_h */
@@ -0,0 +1,113 @@
+//
+//  PLReverseDependencyIndex.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLReverseDependencyIndex.h"
+
+#include <algorithm>
+#include <memory>
+
+PLReverseDependencyIndex::PLReverseDependencyIndex(pkgCache &cache) : _packageCount(cache.Head().PackageCount), _groupsBySatisfier(_packageCount), _conflictsByTarget(_packageCount) {
+    for (pkgCache::PkgIterator package = cache.PkgBegin(); !package.end(); package++) {
+        pkgCache::VerIterator installed = package.CurrentVer();
+        if (installed.end()) continue;
+
+        pkgCache::DepIterator dep = installed.DependsList();
+        while (!dep.end()) {
+            pkgCache::DepIterator start;
+            pkgCache::DepIterator end;
+            dep.GlobOr(start, end);
+            if (start->Type == pkgCache::Dep::Conflicts || start->Type == pkgCache::Dep::DpkgBreaks) {
+                for (pkgCache::DepIterator conflict = start; ; conflict++) {
+                    _conflictsByTarget[conflict.TargetPkg()->ID].push_back(conflict);
+                    if (conflict == end) break;
+                }
+                continue;
+            }
+            if (start->Type != pkgCache::Dep::Depends && start->Type != pkgCache::Dep::PreDepends) continue;
+
+            uint32_t satisfiersStart = (uint32_t)_satisfiers.size();
+            while (true) {
+                // AllTargets includes versions that provide the target, so provides are covered without a separate pass
+                std::unique_ptr<pkgCache::Version *[]> versions(start.AllTargets());
+                for (pkgCache::Version **target = versions.get(); *target != NULL; target++) {
+                    pkgCache::VerIterator version(cache, *target);
+                    pkgCache::PkgIterator parent = version.ParentPkg();
+                    if (parent.CurrentVer() == version && parent->ID != package->ID) {
+                        _satisfiers.push_back(parent->ID);
+                    }
+                }
+
+                if (start == end) break;
+                start++;
+            }
+
+            auto first = _satisfiers.begin() + satisfiersStart;
+            std::sort(first, _satisfiers.end());
+            _satisfiers.erase(std::unique(first, _satisfiers.end()), _satisfiers.end());
+
+            uint32_t satisfiersCount = (uint32_t)_satisfiers.size() - satisfiersStart;
+            if (satisfiersCount == 0) continue;
+
+            uint32_t groupIndex = (uint32_t)_groups.size();
+            _groups.push_back({package->ID, satisfiersStart, satisfiersCount});
+            for (uint32_t i = satisfiersStart; i < satisfiersStart + satisfiersCount; i++) {
+                _groupsBySatisfier[_satisfiers[i]].push_back(groupIndex);
+            }
+        }
+    }
+}
+
+std::vector<map_id_t> PLReverseDependencyIndex::dependents(map_id_t packageID) const {
+    std::vector<map_id_t> dependents;
+    if (packageID >= _groupsBySatisfier.size()) return dependents;
+
+    for (uint32_t groupIndex : _groupsBySatisfier[packageID]) {
+        dependents.push_back(_groups[groupIndex].dependent);
+    }
+    std::sort(dependents.begin(), dependents.end());
+    dependents.erase(std::unique(dependents.begin(), dependents.end()), dependents.end());
+    return dependents;
+}
+
+PLBitset PLReverseDependencyIndex::removalImpact(std::vector<map_id_t> const &packageIDs) const {
+    PLBitset removed(_packageCount);
+    std::vector<map_id_t> pending;
+    for (map_id_t packageID : packageIDs) {
+        if (packageID >= _packageCount || removed.test(packageID)) continue;
+
+        removed.set(packageID);
+        pending.push_back(packageID);
+    }
+
+    // A dependent only breaks once every installed package that satisfied one of its or-groups is gone
+    while (!pending.empty()) {
+        map_id_t packageID = pending.back();
+        pending.pop_back();
+
+        for (uint32_t groupIndex : _groupsBySatisfier[packageID]) {
+            Group const &group = _groups[groupIndex];
+            if (removed.test(group.dependent)) continue;
+
+            bool broken = true;
+            for (uint32_t i = group.satisfiersStart; i < group.satisfiersStart + group.satisfiersCount; i++) {
+                if (!removed.test(_satisfiers[i])) {
+                    broken = false;
+                    break;
+                }
+            }
+            if (!broken) continue;
+
+            removed.set(group.dependent);
+            pending.push_back(group.dependent);
+        }
+    }
+
+    for (map_id_t packageID : packageIDs) {
+        removed.reset(packageID);
+    }
+    return removed;
+}
@@ -0,0 +1,88 @@
+//
+//  PLSnapshot.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLSnapshot_h
+#define PLSnapshot_h
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ When each package and each of its versions was first seen, persisted between imports so that frontends can list what is new or updated.
+
+ Every import hashes the candidate stanzas and diffs them against the previous snapshot, only stanzas whose hash changed are compared any further. The first snapshot that is ever taken records every package as seen at time `0` so that an existing catalog doesn't show up as new. Package IDs are `pkgCache::Package::ID` values.
+ */
+class PLSnapshot {
+public:
+    struct Times {
+        int64_t packageFirstSeen;
+        int64_t versionFirstSeen;
+    };
+
+    explicit PLSnapshot(size_t packageCount);
+
+    /*!
+     Load the previous snapshot.
+
+     - returns: Whether or not a valid snapshot exists at `path`.
+     */
+    bool load(std::string const &path);
+
+    /*!
+     Add the candidate stanza of a package, diffing it against the loaded snapshot.
+
+     - parameter packageID: The ID of the package.
+     - parameter name: The full name of the package, used as the key between snapshots.
+     - parameter version: The version string of the candidate.
+     - parameter start: The beginning of the candidate's stanza.
+     - parameter stop: The end of the candidate's stanza.
+     - parameter now: The time to record for anything that hasn't been seen before.
+     - parameter isNewer: Called with the new and old version strings when the stanza changed, returns whether or not the new version is an update.
+     */
+    void addPackage(uint32_t packageID, std::string const &name, std::string const &version, const char *start, const char *stop, int64_t now, std::function<bool(std::string const &newVersion, std::string const &oldVersion)> const &isNewer);
+
+    /*!
+     Write every package that has been added to `path`, replacing the previous snapshot.
+     */
+    bool save(std::string const &path) const;
+
+    /*!
+     The first seen times of a package, both are `-1` if the package isn't in the snapshot.
+     */
+    Times times(uint32_t packageID) const {
+        return packageID < _times.size() ? _times[packageID] : Times{-1, -1};
+    }
+
+    /*!
+     Packages first seen after `time`, most recent first.
+     */
+    std::vector<uint32_t> packagesAddedSince(int64_t time) const;
+
+    /*!
+     Packages that were already known whose current version was first seen after `time`, most recent first.
+     */
+    std::vector<uint32_t> packagesUpdatedSince(int64_t time) const;
+
+private:
+    struct Entry {
+        uint64_t hash;
+        int64_t packageFirstSeen;
+        int64_t versionFirstSeen;
+        std::string version;
+    };
+
+    static uint64_t hashStanza(const char *start, const char *stop);
+
+    std::unordered_map<std::string, Entry> _previous;
+    std::unordered_map<std::string, Entry> _current;
+    std::vector<Times> _times;
+    bool _hasPrevious;
+};
+
+#endif /* PLSnapshot_h */
@@ -0,0 +1,155 @@
+//
+//  PLSnapshot.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLSnapshot.h"
+
+#include <xxhash.h>
+
+#include <algorithm>
+#include <stdio.h>
+
+static const uint32_t PLSnapshotMagic = 0x4e53504c; // "PLSN"
+static const uint32_t PLSnapshotFormat = 1;
+
+PLSnapshot::PLSnapshot(size_t packageCount) : _times(packageCount, {-1, -1}), _hasPrevious(false) {}
+
+uint64_t PLSnapshot::hashStanza(const char *start, const char *stop) {
+    return XXH3_64bits(start, stop - start);
+}
+
+static bool PLSnapshotRead(FILE *file, void *value, size_t size) {
+    return fread(value, size, 1, file) == 1;
+}
+
+static bool PLSnapshotReadString(FILE *file, std::string &value) {
+    uint16_t length;
+    if (!PLSnapshotRead(file, &length, sizeof(length))) return false;
+    value.resize(length);
+    return length == 0 || PLSnapshotRead(file, &value[0], length);
+}
+
+bool PLSnapshot::load(std::string const &path) {
+    _previous.clear();
+    _hasPrevious = false;
+
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    uint32_t magic, format, count;
+    bool valid = PLSnapshotRead(file, &magic, sizeof(magic)) && magic == PLSnapshotMagic
+        && PLSnapshotRead(file, &format, sizeof(format)) && format == PLSnapshotFormat
+        && PLSnapshotRead(file, &count, sizeof(count));
+
+    if (valid) {
+        _previous.reserve(count);
+        for (uint32_t i = 0; i < count && valid; i++) {
+            std::string name;
+            Entry entry;
+            valid = PLSnapshotRead(file, &entry.hash, sizeof(entry.hash))
+                && PLSnapshotRead(file, &entry.packageFirstSeen, sizeof(entry.packageFirstSeen))
+                && PLSnapshotRead(file, &entry.versionFirstSeen, sizeof(entry.versionFirstSeen))
+                && PLSnapshotReadString(file, name)
+                && PLSnapshotReadString(file, entry.version);
+            if (valid) _previous.emplace(std::move(name), std::move(entry));
+        }
+    }
+    fclose(file);
+
+    // A truncated snapshot is treated as missing rather than half applied
+    if (!valid) _previous.clear();
+    _hasPrevious = valid;
+    return valid;
+}
+
+void PLSnapshot::addPackage(uint32_t packageID, std::string const &name, std::string const &version, const char *start, const char *stop, int64_t now, std::function<bool(std::string const &newVersion, std::string const &oldVersion)> const &isNewer) {
+    if (packageID >= _times.size()) return;
+
+    uint64_t hash = hashStanza(start, stop);
+    Entry &entry = _current[name];
+    auto previous = _previous.find(name);
+    if (previous == _previous.end()) {
+        int64_t seen = _hasPrevious ? now : 0;
+        entry = {hash, seen, seen, version};
+    } else {
+        entry = previous->second;
+        if (entry.hash != hash) {
+            // Only stanzas that changed need their versions compared
+            entry.hash = hash;
+            if (entry.version != version) {
+                if (isNewer(version, entry.version)) {
+                    entry.versionFirstSeen = now;
+                }
+                entry.version = version;
+            }
+        }
+    }
+    _times[packageID] = {entry.packageFirstSeen, entry.versionFirstSeen};
+}
+
+static bool PLSnapshotWrite(FILE *file, const void *value, size_t size) {
+    return size == 0 || fwrite(value, size, 1, file) == 1;
+}
+
+static bool PLSnapshotWriteString(FILE *file, std::string const &value) {
+    uint16_t length = (uint16_t)std::min<size_t>(value.size(), UINT16_MAX);
+    return PLSnapshotWrite(file, &length, sizeof(length)) && PLSnapshotWrite(file, value.data(), length);
+}
+
+bool PLSnapshot::save(std::string const &path) const {
+    std::string temporaryPath = path + ".new";
+    FILE *file = fopen(temporaryPath.c_str(), "wb");
+    if (!file) return false;
+
+    uint32_t count = (uint32_t)_current.size();
+    bool written = PLSnapshotWrite(file, &PLSnapshotMagic, sizeof(PLSnapshotMagic))
+        && PLSnapshotWrite(file, &PLSnapshotFormat, sizeof(PLSnapshotFormat))
+        && PLSnapshotWrite(file, &count, sizeof(count));
+    for (auto const &item : _current) {
+        if (!written) break;
+        Entry const &entry = item.second;
+        written = PLSnapshotWrite(file, &entry.hash, sizeof(entry.hash))
+            && PLSnapshotWrite(file, &entry.packageFirstSeen, sizeof(entry.packageFirstSeen))
+            && PLSnapshotWrite(file, &entry.versionFirstSeen, sizeof(entry.versionFirstSeen))
+            && PLSnapshotWriteString(file, item.first)
+            && PLSnapshotWriteString(file, entry.version);
+    }
+
+    if (fclose(file) != 0 || !written) {
+        remove(temporaryPath.c_str());
+        return false;
+    }
+    return rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+std::vector<uint32_t> PLSnapshot::packagesAddedSince(int64_t time) const {
+    std::vector<uint32_t> packageIDs;
+    for (uint32_t packageID = 0; packageID < _times.size(); packageID++) {
+        if (_times[packageID].packageFirstSeen > time) {
+            packageIDs.push_back(packageID);
+        }
+    }
+
+    std::stable_sort(packageIDs.begin(), packageIDs.end(), [&](uint32_t a, uint32_t b) {
+        return _times[a].packageFirstSeen > _times[b].packageFirstSeen;
+    });
+    return packageIDs;
+}
+
+std::vector<uint32_t> PLSnapshot::packagesUpdatedSince(int64_t time) const {
+    std::vector<uint32_t> packageIDs;
+    for (uint32_t packageID = 0; packageID < _times.size(); packageID++) {
+        Times const &times = _times[packageID];
+        if (times.versionFirstSeen > time && times.versionFirstSeen > times.packageFirstSeen) {
+            packageIDs.push_back(packageID);
+        }
+    }
+
+    std::stable_sort(packageIDs.begin(), packageIDs.end(), [&](uint32_t a, uint32_t b) {
+        return _times[a].versionFirstSeen > _times[b].versionFirstSeen;
+    });
+    return packageIDs;
+}
@@ -0,0 +1,82 @@
+//
+//  PLTagIndex.h
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#ifndef PLTagIndex_h
+#define PLTagIndex_h
+
+#import "PLBitset.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ Interned `Tag` values for every package in a cache generation.
+
+ Each distinct tag is stored once and owns a bitset of the packages that have it, so tag and role filters become bitwise operations over the whole catalog. Package IDs are `pkgCache::Package::ID` values.
+ */
+class PLTagIndex {
+public:
+    /*!
+     Package roles, in the same order as the Swift `PackageRole` enum.
+     */
+    enum Role : uint8_t {
+        RoleUser,
+        RoleEndUser,
+        RoleHacker,
+        RoleDeveloper,
+        RoleCydia,
+    };
+
+    explicit PLTagIndex(size_t packageCount);
+
+    /*!
+     Parse and intern the comma separated `Tag` field of a package.
+     */
+    void addPackage(uint32_t packageID, const char *tags, size_t length);
+
+    /*!
+     Remove a package from every posting it is in, leaving it as a user package without tags. Interned tags are kept even if no package has them anymore.
+     */
+    void removePackage(uint32_t packageID);
+
+    /*!
+     The packages that have `tag`, or `nullptr` if no package has it.
+     */
+    const PLBitset *packagesWithTag(std::string const &tag) const;
+
+    /*!
+     The packages whose role is in `roleMask`, where each role is represented by `1 << role`.
+     */
+    PLBitset packagesWithRoles(uint32_t roleMask) const;
+
+    /*!
+     The role of a package, `RoleUser` if it doesn't specify one.
+     */
+    Role role(uint32_t packageID) const {
+        return packageID < _roles.size() ? (Role)_roles[packageID] : RoleUser;
+    }
+
+    /*!
+     The tags of a package in the order they appear in its control file.
+     */
+    std::vector<std::string const *> tags(uint32_t packageID) const;
+
+    size_t packageCount() const { return _roles.size(); }
+
+private:
+    uint32_t intern(std::string const &tag);
+
+    std::unordered_map<std::string, uint32_t> _tagIDs;
+    std::vector<std::string> _tagNames;
+    std::vector<PLBitset> _postings;
+    std::vector<std::vector<uint32_t>> _packageTags;
+    std::vector<uint8_t> _roles;
+    std::vector<PLBitset> _rolePostings;
+};
+
+#endif /* PLTagIndex_h */
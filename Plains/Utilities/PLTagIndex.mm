@@ -0,0 +1,110 @@
+//
+//  PLTagIndex.mm
+//  Plains
+//
+//  Created by agent on 10/19/26.
+//
+
+#import "PLTagIndex.h"
+
+#include <ctype.h>
+#include <string.h>
+
+static const char *const PLTagIndexRoleNames[] = {"user", "enduser", "hacker", "developer", "cydia"};
+
+PLTagIndex::PLTagIndex(size_t packageCount) : _packageTags(packageCount), _roles(packageCount, RoleUser), _rolePostings(RoleCydia + 1, PLBitset(packageCount)) {
+    // Packages without a role tag are user packages
+    _rolePostings[RoleUser].fill();
+}
+
+uint32_t PLTagIndex::intern(std::string const &tag) {
+    auto existing = _tagIDs.find(tag);
+    if (existing != _tagIDs.end()) {
+        return existing->second;
+    }
+
+    uint32_t tagID = (uint32_t)_tagNames.size();
+    _tagIDs.emplace(tag, tagID);
+    _tagNames.push_back(tag);
+    _postings.emplace_back(_roles.size());
+    return tagID;
+}
+
+void PLTagIndex::addPackage(uint32_t packageID, const char *tags, size_t length) {
+    if (packageID >= _roles.size()) return;
+
+    bool hasRole = false;
+    const char *end = tags + length;
+    const char *start = tags;
+    while (start < end) {
+        const char *comma = (const char *)memchr(start, ',', end - start);
+        const char *stop = comma ?: end;
+
+        const char *tagStart = start;
+        const char *tagStop = stop;
+        while (tagStart < tagStop && isspace(*tagStart)) tagStart++;
+        while (tagStop > tagStart && isspace(tagStop[-1])) tagStop--;
+
+        if (tagStart < tagStop) {
+            std::string tag(tagStart, tagStop - tagStart);
+            uint32_t tagID = intern(tag);
+            _postings[tagID].set(packageID);
+            _packageTags[packageID].push_back(tagID);
+
+            if (!hasRole && tag.compare(0, 6, "role::") == 0) {
+                for (uint8_t role = RoleUser; role <= RoleCydia; role++) {
+                    if (tag.compare(6, std::string::npos, PLTagIndexRoleNames[role]) == 0) {
+                        _roles[packageID] = role;
+                        _rolePostings[RoleUser].reset(packageID);
+                        _rolePostings[role].set(packageID);
+                        hasRole = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        start = stop + 1;
+    }
+}
+
+void PLTagIndex::removePackage(uint32_t packageID) {
+    if (packageID >= _roles.size()) return;
+
+    for (uint32_t tagID : _packageTags[packageID]) {
+        _postings[tagID].reset(packageID);
+    }
+    _packageTags[packageID].clear();
+
+    _rolePostings[_roles[packageID]].reset(packageID);
+    _roles[packageID] = RoleUser;
+    _rolePostings[RoleUser].set(packageID);
+}
+
+const PLBitset *PLTagIndex::packagesWithTag(std::string const &tag) const {
+    auto tagID = _tagIDs.find(tag);
+    if (tagID == _tagIDs.end()) {
+        return nullptr;
+    }
+    return &_postings[tagID->second];
+}
+
+PLBitset PLTagIndex::packagesWithRoles(uint32_t roleMask) const {
+    PLBitset result(_roles.size());
+    for (uint8_t role = RoleUser; role <= RoleCydia; role++) {
+        if (roleMask & (1 << role)) {
+            result |= _rolePostings[role];
+        }
+    }
+    return result;
+}
+
+std::vector<std::string const *> PLTagIndex::tags(uint32_t packageID) const {
+    std::vector<std::string const *> result;
+    if (packageID >= _packageTags.size()) return result;
+
+    for (uint32_t tagID : _packageTags[packageID]) {
+        result.push_back(&_tagNames[tagID]);
+    }
+    return result;
+}
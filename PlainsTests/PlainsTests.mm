@@ -8,9 +8,80 @@
 #import <XCTest/XCTest.h>
 
 #import <Plains/Plains.h>
+#import "Utilities/PLAuthorIndex.h"
+#import "Utilities/PLDependencyClosure.h"
 
 #include <sys/stat.h>
 
+#include <string>
+#include <vector>
+
+static void PLTestAppendField(std::string &header, size_t width, std::string const &value) {
+    std::string field = value.substr(0, width);
+    field.resize(width, '\0');
+    header += field;
+}
+
+static std::string PLTestOctal(unsigned long long value, size_t digits) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%0*llo", (int)digits, value);
+    return buffer;
+}
+
+// A ustar archive holding a single ./control member
+static std::string PLTestControlTar(std::string const &control) {
+    std::string header;
+    PLTestAppendField(header, 100, "./control");
+    PLTestAppendField(header, 8, "0000644");
+    PLTestAppendField(header, 8, "0000000");
+    PLTestAppendField(header, 8, "0000000");
+    PLTestAppendField(header, 12, PLTestOctal(control.size(), 11));
+    PLTestAppendField(header, 12, PLTestOctal(0, 11));
+    header += "        ";
+    header += '0';
+    PLTestAppendField(header, 100, "");
+    PLTestAppendField(header, 6, "ustar");
+    header += "00";
+    header.resize(512, '\0');
+
+    unsigned int checksum = 0;
+    for (unsigned char byte : header) checksum += byte;
+    header.replace(148, 8, PLTestOctal(checksum, 6) + std::string(1, '\0') + " ");
+
+    std::string tar = header + control;
+    tar.resize((tar.size() + 511) / 512 * 512, '\0');
+    tar.append(1024, '\0');
+    return tar;
+}
+
+// Write a .deb with the given control stanza and no files, enough for libapt to index it
+static NSString *PLTestWriteDeb(NSString *directory, NSString *control) {
+    std::vector<std::pair<std::string, std::string>> members = {
+        {"debian-binary", "2.0\n"},
+        {"control.tar", PLTestControlTar(control.UTF8String)},
+        {"data.tar", std::string(1024, '\0')},
+    };
+
+    std::string archive = "!<arch>\n";
+    for (auto const &member : members) {
+        std::string header;
+        header += (member.first + std::string(16, ' ')).substr(0, 16);
+        header += (std::string("0") + std::string(12, ' ')).substr(0, 12);
+        header += (std::string("0") + std::string(6, ' ')).substr(0, 6);
+        header += (std::string("0") + std::string(6, ' ')).substr(0, 6);
+        header += (std::string("100644") + std::string(8, ' ')).substr(0, 8);
+        header += (std::to_string(member.second.size()) + std::string(10, ' ')).substr(0, 10);
+        header += "`\n";
+        archive += header + member.second;
+        if (member.second.size() % 2) archive += '\n';
+    }
+
+    NSString *name = [[control componentsSeparatedByString:@"\n"].firstObject substringFromIndex:@"Package: ".length];
+    NSString *path = [directory stringByAppendingPathComponent:[name stringByAppendingPathExtension:@"deb"]];
+    [[NSData dataWithBytes:archive.data() length:archive.size()] writeToFile:path atomically:YES];
+    return path;
+}
+
 
 @interface PlainsTests : XCTestCase
 @end
@@ -101,4 +172,145 @@ static PLConfig *config;
     XCTAssertEqual(beforeCount, finalCount);
 }
 
+- (void)testBulkFieldValues {
+    PLPackageManager *packageManager = [PLPackageManager sharedInstance];
+    NSArray <PLPackage *> *packages = [packageManager.packages subarrayWithRange:NSMakeRange(0, MIN(packageManager.packages.count, 50))];
+    NSArray <NSString *> *fields = @[@"Package", @"Section", @"Author", @"Tag"];
+
+    NSDictionary <NSString *, NSArray *> *values = [packageManager valuesForFields:fields ofPackages:packages];
+    
+    // Read the stanzas through libapt directly, getField: goes through the same record cache as the bulk read
+    pkgRecords *records = [packageManager records];
+    XCTAssertTrue(records != NULL);
+    if (!records) return;
+    
+    for (NSString *field in fields) {
+        XCTAssertEqual(values[field].count, packages.count);
+        for (NSUInteger i = 0; i < packages.count; i++) {
+            std::string value = records->Lookup(packages[i].verIterator.FileList()).RecordField(field.UTF8String);
+            id expected = value.empty() ? [NSNull null] : [NSString stringWithUTF8String:value.c_str()];
+            XCTAssertEqualObjects(values[field][i], expected);
+        }
+    }
+}
+
+- (void)testAuthorIndexSharedEmail {
+    PLAuthorIndex index(4);
+    index.addPackage(2, "Jane Doe <jane@example.com>");
+    index.addPackage(0, "J. Doe <Jane@example.com>");
+    index.addPackage(3, "Someone Else <else@example.com>");
+
+    // Each package keeps the name its own field uses
+    XCTAssertTrue(index.author(0)->name == "J. Doe");
+    XCTAssertTrue(index.author(2)->name == "Jane Doe");
+
+    // Both spellings are the same person, and either one can be searched for
+    XCTAssertTrue(index.packages("Jane Doe", "jane@example.com") == std::vector<uint32_t>({0, 2}));
+    XCTAssertTrue(index.packages("J. Doe", "JANE@example.com") == std::vector<uint32_t>({0, 2}));
+    XCTAssertTrue(index.search(PLAuthorIndex::fold("j. doe")) == std::vector<uint32_t>({0}));
+    XCTAssertTrue(index.search(PLAuthorIndex::fold("jane")) == std::vector<uint32_t>({2}));
+
+    // A pin update moves a package between people without breaking the ID order
+    index.removePackage(3);
+    index.addPackage(3, "J. Doe <jane@example.com>");
+    index.removePackage(0);
+    index.addPackage(1, "Jane Doe <jane@example.com>");
+    XCTAssertTrue(index.packages("Jane Doe", "jane@example.com") == std::vector<uint32_t>({1, 2, 3}));
+    XCTAssertTrue(index.packages("Someone Else", "else@example.com").empty());
+}
+
+/*!
+ Build a cache with the given control stanzas added as local packages, and work out the closure of each of them.
+ */
+- (NSDictionary <NSString *, NSArray <NSString *> *> *)dependencyClosuresOfStanzas:(NSArray <NSString *> *)stanzas {
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+
+    pkgCacheFile cache;
+    NSMutableArray <NSString *> *names = [NSMutableArray new];
+    for (NSString *stanza in stanzas) {
+        NSString *path = PLTestWriteDeb(directory, stanza);
+        XCTAssertTrue(cache.GetSourceList()->AddVolatileFile(path.UTF8String));
+        [names addObject:path.lastPathComponent.stringByDeletingPathExtension];
+    }
+    XCTAssertTrue(cache.Open(NULL, false));
+
+    pkgDepCache *depCache = cache.GetDepCache();
+    pkgCache &packageCache = depCache->GetCache();
+    std::vector<pkgCache::Version *> candidates(packageCache.Head().PackageCount, NULL);
+    for (pkgCache::PkgIterator iterator = packageCache.PkgBegin(); !iterator.end(); iterator++) {
+        pkgCache::VerIterator candidate = depCache->GetPolicy().GetCandidateVer(iterator);
+        if (!candidate.end()) candidates[iterator->ID] = candidate;
+    }
+
+    PLDependencyClosure closures(packageCache, candidates);
+    NSMutableDictionary *result = [NSMutableDictionary new];
+    for (NSString *name in names) {
+        pkgCache::PkgIterator iterator = packageCache.FindPkg(name.UTF8String);
+        XCTAssertFalse(iterator.end());
+        if (iterator.end()) continue;
+
+        NSMutableArray *closure = [NSMutableArray new];
+        for (map_id_t packageID : *closures.closure(pkgCache::VerIterator(packageCache, candidates[iterator->ID]))) {
+            pkgCache::PkgIterator member(packageCache, packageCache.PkgP + packageID);
+            [closure addObject:[NSString stringWithUTF8String:member.Name()]];
+        }
+        [closure sortUsingSelector:@selector(compare:)];
+        result[name] = closure;
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:nil];
+    return result;
+}
+
+- (void)testDependencyClosureOrGroupsAndProvides {
+    NSDictionary *closures = [self dependencyClosuresOfStanzas:@[
+        @"Package: plains-test-app\nVersion: 1.0\nArchitecture: all\nDepends: plains-test-missing | plains-test-virtual, plains-test-lib | plains-test-other\nDescription: Test\n",
+        @"Package: plains-test-provider\nVersion: 1.0\nArchitecture: all\nProvides: plains-test-virtual\nDescription: Test\n",
+        @"Package: plains-test-lib\nVersion: 1.0\nArchitecture: all\nDescription: Test\n",
+        @"Package: plains-test-other\nVersion: 1.0\nArchitecture: all\nDescription: Test\n",
+    ]];
+
+    // The missing alternative falls through to the provider, and only the first available alternative of the second group is pulled in
+    NSArray *expected = @[@"plains-test-app", @"plains-test-lib", @"plains-test-provider"];
+    XCTAssertEqualObjects(closures[@"plains-test-app"], expected);
+    XCTAssertEqualObjects(closures[@"plains-test-other"], @[@"plains-test-other"]);
+}
+
+- (void)testDependencyClosureCycle {
+    NSDictionary *closures = [self dependencyClosuresOfStanzas:@[
+        @"Package: plains-test-a\nVersion: 1.0\nArchitecture: all\nDepends: plains-test-b\nDescription: Test\n",
+        @"Package: plains-test-b\nVersion: 1.0\nArchitecture: all\nDepends: plains-test-c\nDescription: Test\n",
+        @"Package: plains-test-c\nVersion: 1.0\nArchitecture: all\nDepends: plains-test-a, plains-test-d\nDescription: Test\n",
+        @"Package: plains-test-d\nVersion: 1.0\nArchitecture: all\nDescription: Test\n",
+    ]];
+
+    // Every package in the cycle shares one closure, which also holds what the cycle depends on
+    NSArray *expected = @[@"plains-test-a", @"plains-test-b", @"plains-test-c", @"plains-test-d"];
+    XCTAssertEqualObjects(closures[@"plains-test-a"], expected);
+    XCTAssertEqualObjects(closures[@"plains-test-b"], expected);
+    XCTAssertEqualObjects(closures[@"plains-test-c"], expected);
+    XCTAssertEqualObjects(closures[@"plains-test-d"], @[@"plains-test-d"]);
+}
+
+- (void)testSolverBenchmark {
+    PLPackageManager *packageManager = [PLPackageManager sharedInstance];
+    PLPackage *package;
+    for (PLPackage *candidate in packageManager.packages) {
+        if (!candidate.isInstalled) {
+            package = candidate;
+            break;
+        }
+    }
+    if (!package) return;
+
+    NSArray *scenarios = @[@{package.identifier: @(PLQueueInstall)}];
+    NSArray <NSDictionary *> *results = [[PLQueue sharedInstance] benchmarkSolvers:@[@"internal"] withScenarios:scenarios timeout:5];
+    XCTAssertEqual(results.count, 1);
+    XCTAssertEqualObjects(results.firstObject[@"solver"], @"internal");
+    XCTAssertFalse([results.firstObject[@"external"] boolValue]);
+    XCTAssertGreaterThanOrEqual([results.firstObject[@"size"] unsignedIntegerValue], 1);
+    XCTAssertEqual([PLQueue sharedInstance].count, 0);
+}
+
 @end